@@ -150,7 +150,9 @@ class Benchmark {
           // TODO: hrtime
           this._timeMap.set(config, Date.now());
         },
-        end: operations => {
+        // `extra` is an optional object of additional figures reported along
+        // with the rate, e.g. latency percentiles.
+        end: (operations, extra) => {
           // Get elapsed time now and do error checking later for accuracy.
           // TODO: hrtime
           const now = Date.now();
@@ -172,19 +174,20 @@ class Benchmark {
           const time = this._timeMap.get(config);
           const elapsedInSeconds = (now - time) / 1000;
           const rate = operations / elapsedInSeconds;
-          this.report(rate, elapsedInSeconds, config);
+          this.report(rate, elapsedInSeconds, config, extra);
           resolve();
         },
       }));
     }
   }
 
-  report(rate, elapsedInSeconds, config) {
+  report(rate, elapsedInSeconds, config, extra) {
     sendResult({
       name: this.name,
       conf: config,
       rate,
       time: elapsedInSeconds,
+      extra,
       type: 'report',
     });
   }
@@ -201,7 +204,11 @@ function formatResult(data) {
   let rate = data.rate.toString().split('.');
   rate[0] = rate[0].replace(/(\d)(?=(?:\d\d\d)+(?!\d))/g, '$1,');
   rate = (rate[1] ? rate.join('.') : rate[0]);
-  return `"${data.name}", "${conf}", ${data.rate}, ${data.time}`;
+  if (data.extra == null) {
+    return `"${data.name}", "${conf}", ${data.rate}, ${data.time}`;
+  }
+  const extra = Object.keys(data.extra).map(key => `${key}=${data.extra[key]}`).join(' ');
+  return `"${data.name}", "${conf}", ${data.rate}, ${data.time}, "${extra}"`;
 }
 
 function sendResult(data) {
@@ -0,0 +1,79 @@
+/* eslint-env node */
+'use strict';
+
+const http = require('http');
+const http2 = require('http2');
+
+const kHttp1Port = 30123;
+const kH2cPort = 30124;
+
+// Response bodies are cached by size to keep the server out of the way.
+const bodies = new Map();
+function getBody(size) {
+  let body = bodies.get(size);
+  if (body == null) {
+    body = Buffer.alloc(size, 'a');
+    bodies.set(size, body);
+  }
+  return body;
+}
+
+// GET /bytes/<size>: responds with <size> bytes.
+// POST /echo: responds with the request body.
+// `?close=1` disables keep-alive of the HTTP/1.1 connection.
+function handle(req, res) {
+  const url = new URL(req.url, 'http://localhost');
+  if (url.searchParams.get('close') === '1' && req.httpVersionMajor === 1) {
+    res.setHeader('connection', 'close');
+  }
+  const match = url.pathname.match(/^\/bytes\/(\d+)$/);
+  if (match) {
+    const body = getBody(Number.parseInt(match[1], 10));
+    res.setHeader('content-length', body.byteLength);
+    res.end(body);
+    return;
+  }
+  if (url.pathname === '/echo') {
+    req.pipe(res);
+    return;
+  }
+  res.statusCode = 404;
+  res.end();
+}
+
+class LoopbackServer {
+  #http1Server = http.createServer({ keepAliveTimeout: 60_000 }, handle);
+  // h2c with prior knowledge.
+  #h2cServer = http2.createServer({}, handle);
+
+  async start() {
+    await Promise.all([
+      listen(this.#http1Server, kHttp1Port),
+      listen(this.#h2cServer, kH2cPort),
+    ]);
+  }
+
+  unref() {
+    this.#http1Server.unref();
+    this.#h2cServer.unref();
+  }
+}
+
+function listen(server, port) {
+  return new Promise((resolve, reject) => {
+    server.once('error', reject);
+    server.listen(port, '127.0.0.1', () => {
+      server.off('error', reject);
+      resolve();
+    });
+  });
+}
+
+module.exports = LoopbackServer;
+
+if (require.main === module) {
+  new LoopbackServer().start()
+    .then(() => {
+      console.log(`listening on http/1.1 ${kHttp1Port}, h2c ${kH2cPort}`);
+    });
+}
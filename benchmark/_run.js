@@ -7,6 +7,10 @@ const fs = require('fs');
 
 const fixtures = require('../test/common/fixtures');
 const ResourceServer = require('../test/common/resource-server');
+const LoopbackServer = require('./_loopback_server');
+
+// Shared by the benchmarks of a run.
+let loopbackServerFuture;
 
 class BenchmarkRunner {
   constructor(filepath, options) {
@@ -90,17 +94,42 @@ ${this.code}
     if (this.options.set) {
       benchmarkArgs.push(...this.options.set);
     }
+    if (this.meta['same-origin-shared-data'] === 'true') {
+      const sameOriginSharedData = path.join(__dirname, '.tmp', 'caches', this.filepath);
+      fs.rmSync(sameOriginSharedData, { recursive: true, force: true });
+      fs.mkdirSync(sameOriginSharedData, { recursive: true });
+      execArgv.push(`--same-origin-shared-data=${sameOriginSharedData}`);
+    }
+    if (this.agent) {
+      execArgv.push('--has-agent', `--agent-ipc=${this.agentServerPath}`, '--agent-cred=foobar');
+    }
     if (this.meta.flags) {
       execArgv.push(...this.meta.flags.split(' '));
     }
 
-    const env = {
-      ...process.env,
-      BENCHMARK_ARGV: benchmarkArgs.join(' '),
-    };
-    return this.spawn(fixtures.path('product', 'aworker'), [ ...execArgv, runnerPath ], {
-      env,
-    });
+    // Workers share the same origin shared data directory and run
+    // concurrently, each one reports its own results.
+    const workers = Number.parseInt(this.meta.workers ?? '1', 10);
+    const futures = [];
+    for (let idx = 0; idx < workers; idx++) {
+      const env = {
+        ...process.env,
+        BENCHMARK_ARGV: benchmarkArgs.join(' '),
+        BENCHMARK_WORKER_ID: `${idx}`,
+      };
+      futures.push(this.spawn(fixtures.path('product', 'aworker'), [ ...execArgv, runnerPath ], {
+        env,
+      }));
+    }
+    return Promise.all(futures);
+  }
+
+  async startAgent() {
+    const { NoslatedDelegateService } = require(path.join(fixtures.path('project', 'noslated'), 'build/delegate'));
+    this.agentServerPath = fixtures.path('tmpdir', 'noslated.sock');
+    this.agent = new NoslatedDelegateService(this.agentServerPath);
+    await this.agent.start();
+    this.agent.register('foobar');
   }
 
   async run() {
@@ -109,7 +138,22 @@ ${this.code}
       await this.resourceServer.start();
       this.resourceServer.unref();
     }
-    return this.runWorker();
+    if (this.meta['loopback-server']) {
+      if (loopbackServerFuture == null) {
+        const loopbackServer = new LoopbackServer();
+        loopbackServerFuture = loopbackServer.start()
+          .then(() => loopbackServer.unref());
+      }
+      await loopbackServerFuture;
+    }
+    if (this.meta.agent === 'true') {
+      await this.startAgent();
+    }
+    try {
+      return await this.runWorker();
+    } finally {
+      await this.agent?.close();
+    }
   }
 }
 
@@ -0,0 +1,35 @@
+// META: same-origin-shared-data=true
+'use strict';
+
+createBenchmark(main, {
+  // Every put rewrites the whole cache, keep the setup affordable.
+  entries: [ 10, 100, 1000 ],
+  size: [ 1024 ],
+});
+
+async function prepare(entries, size) {
+  await caches.delete('bench');
+  const cache = await caches.open('bench');
+  const body = new Uint8Array(size);
+  for (let i = 0; i < entries; ++i) {
+    await cache.put(`http://bench.test/${i}`, new Response(body));
+  }
+  return cache;
+}
+
+async function run(cache, entries) {
+  for (let i = 0; i < entries; ++i) {
+    await cache.delete(`http://bench.test/${i}`);
+  }
+}
+
+function main({ entries, size }, bench) {
+  prepare(entries, size)
+    .then(cache => {
+      bench.start();
+      return run(cache, entries);
+    })
+    .then(() => {
+      bench.end(entries);
+    });
+}
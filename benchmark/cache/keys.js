@@ -0,0 +1,34 @@
+// META: same-origin-shared-data=true
+'use strict';
+
+createBenchmark(main, {
+  n: [ 100 ],
+  // Every put rewrites the whole cache, keep the setup affordable.
+  entries: [ 10, 100, 1000 ],
+});
+
+async function prepare(entries) {
+  await caches.delete('bench');
+  const cache = await caches.open('bench');
+  for (let i = 0; i < entries; ++i) {
+    await cache.put(`http://bench.test/${i}`, new Response('bench'));
+  }
+  return cache;
+}
+
+async function run(cache, n) {
+  for (let i = 0; i < n; ++i) {
+    await cache.keys();
+  }
+}
+
+function main({ n, entries }, bench) {
+  prepare(entries)
+    .then(cache => {
+      bench.start();
+      return run(cache, n);
+    })
+    .then(() => {
+      bench.end(n);
+    });
+}
@@ -0,0 +1,51 @@
+// META: same-origin-shared-data=true
+'use strict';
+
+createBenchmark(main, {
+  n: [ 100 ],
+  // Every match reads all entries of the cache, keep the cache small.
+  entries: [ 10, 100 ],
+  size: [ 1024, 64 * 1024 ],
+  vary: [ 'none', 'accept-language' ],
+});
+
+function requestHeaders(vary, idx) {
+  if (vary === 'none') {
+    return {};
+  }
+  return { [vary]: `${idx}` };
+}
+
+async function prepare(entries, size, vary) {
+  await caches.delete('bench');
+  const cache = await caches.open('bench');
+  const body = new Uint8Array(size);
+  for (let i = 0; i < entries; ++i) {
+    const headers = {};
+    if (vary !== 'none') {
+      headers.vary = vary;
+    }
+    await cache.put(new Request(`http://bench.test/${i}`, { headers: requestHeaders(vary, i) }),
+      new Response(body, { headers }));
+  }
+  return cache;
+}
+
+async function run(cache, n, entries, vary) {
+  for (let i = 0; i < n; ++i) {
+    const idx = i % entries;
+    const resp = await cache.match(new Request(`http://bench.test/${idx}`, { headers: requestHeaders(vary, idx) }));
+    await resp.arrayBuffer();
+  }
+}
+
+function main({ n, entries, size, vary }, bench) {
+  prepare(entries, size, vary)
+    .then(cache => {
+      bench.start();
+      return run(cache, n, entries, vary);
+    })
+    .then(() => {
+      bench.end(n);
+    });
+}
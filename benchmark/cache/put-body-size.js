@@ -0,0 +1,30 @@
+// META: same-origin-shared-data=true
+'use strict';
+
+createBenchmark(main, {
+  n: [ 10 ],
+  size: [ 1024, 1024 * 1024, 10 * 1024 * 1024 ],
+});
+
+async function prepare() {
+  await caches.delete('bench');
+  return caches.open('bench');
+}
+
+async function run(cache, n, body) {
+  for (let i = 0; i < n; ++i) {
+    await cache.put(`http://bench.test/${i}`, new Response(body));
+  }
+}
+
+function main({ n, size }, bench) {
+  const body = new Uint8Array(size);
+  prepare()
+    .then(cache => {
+      bench.start();
+      return run(cache, n, body);
+    })
+    .then(() => {
+      bench.end(n);
+    });
+}
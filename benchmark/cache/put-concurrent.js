@@ -0,0 +1,30 @@
+// META: same-origin-shared-data=true
+// META: workers=4
+'use strict';
+
+/**
+ * Multiple workers put entries into the same cache concurrently, which
+ * measures the contention of the cache storage locks.
+ */
+const workerId = aworker.env.BENCHMARK_WORKER_ID;
+
+createBenchmark(main, {
+  n: [ 100 ],
+  size: [ 1024, 1024 * 1024 ],
+});
+
+async function run(n, body) {
+  const cache = await caches.open('bench');
+  for (let i = 0; i < n; ++i) {
+    await cache.put(`http://bench.test/${workerId}/${i}`, new Response(body));
+  }
+}
+
+function main({ n, size }, bench) {
+  const body = new Uint8Array(size);
+  bench.start();
+  run(n, body)
+    .then(() => {
+      bench.end(n);
+    });
+}
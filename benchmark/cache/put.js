@@ -0,0 +1,31 @@
+// META: same-origin-shared-data=true
+'use strict';
+
+createBenchmark(main, {
+  // Every put rewrites the whole cache, the cost grows quadratically.
+  entries: [ 10, 100, 1000 ],
+  size: [ 1024 ],
+});
+
+async function prepare() {
+  await caches.delete('bench');
+  return caches.open('bench');
+}
+
+async function run(cache, entries, body) {
+  for (let i = 0; i < entries; ++i) {
+    await cache.put(`http://bench.test/${i}`, new Response(body));
+  }
+}
+
+function main({ entries, size }, bench) {
+  const body = new Uint8Array(size);
+  prepare()
+    .then(cache => {
+      bench.start();
+      return run(cache, entries, body);
+    })
+    .then(() => {
+      bench.end(entries);
+    });
+}
@@ -0,0 +1,54 @@
+// META: flags=--expose-internals
+// META: loopback-server=true
+'use strict';
+
+// The agent driver doesn't speak h2c, compare HTTP/2 multiplexing of the curl
+// driver with HTTP/1.1 on the same loopback server.
+const { sendFetchReq } = load('fetch/drivers/curl');
+const { HttpVersionOptions } = loadBinding('curl');
+
+createBenchmark(main, {
+  n: [ 5e3 ],
+  protocol: [ 'h2c', 'http1' ],
+  size: [ 64, 256 * 1024 ],
+  parallel: [ 1, 32 ],
+});
+
+async function request(url, options) {
+  const start = performance.now();
+  const { body } = await sendFetchReq(url, 'GET', new Headers(), null, null, options);
+  const reader = body.getReader();
+  while (!(await reader.read()).done);
+  return performance.now() - start;
+}
+
+async function run(url, options, n, latencies) {
+  for (let i = 0; i < n; ++i) {
+    latencies.push(await request(url, options));
+  }
+}
+
+function percentiles(latencies) {
+  latencies.sort((a, b) => a - b);
+  const at = p => latencies[Math.min(latencies.length - 1, Math.floor(latencies.length * p))].toFixed(3);
+  return { p50: at(0.5), p90: at(0.9), p99: at(0.99) };
+}
+
+function main({ n, protocol, size, parallel }, bench) {
+  let url;
+  let options;
+  if (protocol === 'h2c') {
+    url = `http://127.0.0.1:30124/bytes/${size}`;
+    options = { httpVersion: HttpVersionOptions.CURL_HTTP_VERSION_2_PRIOR_KNOWLEDGE };
+  } else {
+    url = `http://127.0.0.1:30123/bytes/${size}`;
+    options = { httpVersion: HttpVersionOptions.CURL_HTTP_VERSION_1_1 };
+  }
+  const nPerRun = Math.floor(n / parallel);
+  const latencies = [];
+  bench.start();
+  Promise.all(new Array(parallel).fill(0).map(() => run(url, options, nPerRun, latencies)))
+    .then(() => {
+      bench.end(nPerRun * parallel, percentiles(latencies));
+    });
+}
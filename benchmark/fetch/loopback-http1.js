@@ -0,0 +1,49 @@
+// META: flags=--expose-internals
+// META: loopback-server=true
+// META: agent=true
+'use strict';
+
+const drivers = {
+  agent: load('fetch/drivers/agent').sendFetchReq,
+  curl: load('fetch/drivers/curl').sendFetchReq,
+};
+
+createBenchmark(main, {
+  n: [ 5e3 ],
+  driver: [ 'curl', 'agent' ],
+  size: [ 64, 256 * 1024 ],
+  parallel: [ 1, 32 ],
+  keepalive: [ 'on', 'off' ],
+});
+
+async function request(sendFetchReq, url) {
+  const start = performance.now();
+  const { body } = await sendFetchReq(url, 'GET', new Headers(), null, null);
+  const reader = body.getReader();
+  while (!(await reader.read()).done);
+  return performance.now() - start;
+}
+
+async function run(sendFetchReq, url, n, latencies) {
+  for (let i = 0; i < n; ++i) {
+    latencies.push(await request(sendFetchReq, url));
+  }
+}
+
+function percentiles(latencies) {
+  latencies.sort((a, b) => a - b);
+  const at = p => latencies[Math.min(latencies.length - 1, Math.floor(latencies.length * p))].toFixed(3);
+  return { p50: at(0.5), p90: at(0.9), p99: at(0.99) };
+}
+
+function main({ n, driver, size, parallel, keepalive }, bench) {
+  const sendFetchReq = drivers[driver];
+  const url = `http://127.0.0.1:30123/bytes/${size}${keepalive === 'off' ? '?close=1' : ''}`;
+  const nPerRun = Math.floor(n / parallel);
+  const latencies = [];
+  bench.start();
+  Promise.all(new Array(parallel).fill(0).map(() => run(sendFetchReq, url, nPerRun, latencies)))
+    .then(() => {
+      bench.end(nPerRun * parallel, percentiles(latencies));
+    });
+}
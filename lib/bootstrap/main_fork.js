@@ -32,6 +32,9 @@ function main() {
       return getExtendableEventExtendedLifetimePromise(serializedEvent);
     })
     .then(() => {
+      if (!options.no_experimental_curl_fetch) {
+        load('fetch/drivers/curl').prewarm();
+      }
       process.setWorkerState(WORKER_STATE_FORK_PREPARED);
     });
 }
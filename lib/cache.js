@@ -7,6 +7,7 @@ const { fetch } = load('fetch/fetch');
 const { AbortController } = load('dom/abort_controller');
 const { createInvalidStateError } = load('dom/exception');
 const agentChannel = load('agent_channel');
+const { setTimeout } = load('timer');
 const binding = loadBinding('cache');
 const options = loadBinding('aworker_options');
 const debug = load('console/debuglog').debuglog('cache');
@@ -19,6 +20,19 @@ const {
 const allowedProtocols = [ 'http:', 'https:' ];
 const batchOperationTypes = [ 'delete', 'put' ];
 const responseArrayBufferStoreKey = Symbol('cache response arraybuffer key');
+const responseLastWriteTimeKey = Symbol('cache response last write time key');
+
+const kLocalLockRetryMinMs = 1;
+const kLocalLockRetryMaxMs = 16;
+const kLocalLockUnknown = 0;
+const kLocalLockAvailable = 1;
+const kLocalLockUnavailable = 2;
+let localLockState = kLocalLockUnknown;
+
+// Evict until the usage falls below 90% of the quota to avoid evicting on
+// every put once the quota has been reached.
+const kEvictionLowWatermarkPercent = 90;
+let evictionPromise = null;
 
 let inited = false;
 function cachePreamble() {
@@ -39,6 +53,60 @@ function resourceIdForCache(cacheName) {
   return `[CachePage]${cacheName}`;
 }
 
+function tryAcquireLocalResource(resourceId, exclusive) {
+  const fd = binding.tryLockResource(resourceId, exclusive);
+  if (fd >= 0) {
+    localLockState = kLocalLockAvailable;
+    let released = false;
+    return {
+      release: () => {
+        if (released) {
+          return;
+        }
+        released = true;
+        binding.unlockResource(resourceId, fd);
+      },
+    };
+  }
+  if (fd === binding.kLockWouldBlock) {
+    localLockState = kLocalLockAvailable;
+    return null;
+  }
+  if (localLockState === kLocalLockUnknown) {
+    // The shared data directory doesn't support file locks, all workers of the
+    // same origin are going to observe the same result.
+    debug('local resource lock is not available(errno: %d), fallback to agent', -fd);
+    localLockState = kLocalLockUnavailable;
+    return null;
+  }
+  throw new Error(`Failed to lock resource(${resourceId}): errno ${-fd}`);
+}
+
+/**
+ * Acquire a shared or exclusive lock of the resource. Workers on the same host
+ * share the same origin shared data directory and are coordinated with the
+ * file locks in it, the agent is only consulted if the file locks are not
+ * available.
+ * @param {string} resourceId -
+ * @param {boolean} exclusive -
+ * @return {Promise<{ release: () => void }>} the lock stub
+ */
+async function acquireResource(resourceId, exclusive) {
+  let delay = kLocalLockRetryMinMs;
+  while (localLockState !== kLocalLockUnavailable) {
+    const stub = tryAcquireLocalResource(resourceId, exclusive);
+    if (stub != null) {
+      return stub;
+    }
+    if (localLockState === kLocalLockUnavailable) {
+      break;
+    }
+    await new Promise(resolve => setTimeout(resolve, delay));
+    delay = Math.min(delay * 2, kLocalLockRetryMaxMs);
+  }
+  return agentChannel.acquireResource(resourceId, exclusive);
+}
+
 function keyValuePairsToTuples(arr) {
   return arr.map(pairs => [ pairs.key, pairs.value ]);
 }
@@ -49,7 +117,7 @@ function tuplesToKeyValuePairs(arr) {
 
 async function sharedResourceFetch(cache, request, options, abortController) {
   const resourceId = `${request.method} ${request.url}`;
-  const resource = await agentChannel.acquireResource(resourceId, /** exclusive */true);
+  const resource = await acquireResource(resourceId, /** exclusive */true);
   try {
     const it = await cache.matchAll(request);
     if (it.length !== 0) {
@@ -73,7 +141,7 @@ async function sharedResourceFetch(cache, request, options, abortController) {
 
 async function listCacheKeys(cacheName) {
   // Read op, non-exclusive
-  const stub = await agentChannel.acquireResource(resourceIdForCache(cacheName), /** exclusive */false);
+  const stub = await acquireResource(resourceIdForCache(cacheName), /** exclusive */false);
   try {
     const page = await new Promise(resolve => {
       binding.readCachePage(cacheName, (error, page) => {
@@ -106,7 +174,7 @@ async function readCacheFullStorage(cacheName, inTransaction = false) {
   let stub;
   if (!inTransaction) {
     // Read op, non-exclusive
-    stub = await agentChannel.acquireResource(resourceIdForCache(cacheName), /** exclusive */false);
+    stub = await acquireResource(resourceIdForCache(cacheName), /** exclusive */false);
   }
   try {
     const page = await new Promise(resolve => {
@@ -146,6 +214,7 @@ async function readCacheFullStorage(cacheName, inTransaction = false) {
       };
       const response = new Response(responseData.body, responseInit);
       response[responseArrayBufferStoreKey] = responseData.body;
+      response[responseLastWriteTimeKey] = item.last_write_time;
       storage.push([ request, response ]);
     }
     return storage;
@@ -168,6 +237,8 @@ async function writeCachePage(cacheName, storage) {
         req_method: request.method,
         req_headers: tuplesToKeyValuePairs(Array.from(request.headers.entries())),
         vary: response.headers.get('vary') ?? '',
+        size: response[responseArrayBufferStoreKey].byteLength,
+        last_write_time: response[responseLastWriteTimeKey],
       });
     }
     binding.writeCachePage(cacheName, items, () => {
@@ -205,6 +276,153 @@ function writeCacheObjectPages(cacheName, storage) {
   return futures;
 }
 
+/**
+ * @param {[Request, Response][]} storage -
+ * @return {number} bytes of the response bodies
+ */
+function cacheUsageBytes(storage) {
+  let bytes = 0;
+  for (const [ , response ] of storage) {
+    bytes += response[responseArrayBufferStoreKey].byteLength;
+  }
+  return bytes;
+}
+
+async function updateCacheStorageUsage(delta) {
+  const resource = await acquireResource(resourceIdForCacheStorage(), /** exclusive */true);
+  let usageBytes;
+  try {
+    usageBytes = await new Promise(resolve => {
+      binding.updateCacheStorageUsage(delta, usageBytes => {
+        debug('cache storage usage: %d bytes', usageBytes);
+        resolve(usageBytes);
+      });
+    });
+  } finally {
+    resource.release();
+  }
+  scheduleEvictionIfNeeded(usageBytes);
+}
+
+function readCachePageEntries(cacheName) {
+  return new Promise(resolve => {
+    binding.readCachePage(cacheName, (error, page) => {
+      if (error) {
+        debug('failed to read cache page', cacheName, error);
+        return resolve([]);
+      }
+      resolve(page);
+    });
+  });
+}
+
+function scheduleEvictionIfNeeded(usageBytes) {
+  const quotaBytes = options.cache_storage_quota_mb * 1024 * 1024;
+  if (quotaBytes === 0 || usageBytes <= quotaBytes || evictionPromise != null) {
+    return;
+  }
+  debug('schedule eviction, usage: %d, quota: %d', usageBytes, quotaBytes);
+  evictionPromise = evictCacheEntries(usageBytes, quotaBytes)
+    .then(
+      bytesFreed => debug('eviction done, freed: %d', bytesFreed),
+      e => debug('eviction failed', e))
+    .finally(() => {
+      evictionPromise = null;
+    });
+}
+
+/**
+ * Evicts least recently written cache entries until the accounted usage of
+ * the origin falls below the low watermark of the quota. The pages are
+ * locked like any other cache operation, one cache at a time.
+ * @param {number} usageBytes -
+ * @param {number} quotaBytes -
+ * @return {Promise<number>} the bytes freed
+ */
+async function evictCacheEntries(usageBytes, quotaBytes) {
+  const bytesToFree = usageBytes - Math.floor(quotaBytes * kEvictionLowWatermarkPercent / 100);
+
+  let cacheNames;
+  const resource = await acquireResource(resourceIdForCacheStorage(), /** exclusive */false);
+  try {
+    cacheNames = await new Promise(resolve => binding.listCacheStorage(resolve));
+  } finally {
+    resource.release();
+  }
+
+  const candidates = [];
+  for (const cacheName of cacheNames) {
+    const stub = await acquireResource(resourceIdForCache(cacheName), /** exclusive */false);
+    try {
+      for (const item of await readCachePageEntries(cacheName)) {
+        candidates.push({
+          cacheName,
+          cacheObjectFilename: item.cache_object_filename,
+          size: item.size,
+          lastWriteTime: item.last_write_time,
+        });
+      }
+    } finally {
+      stub.release();
+    }
+  }
+  // Least recently written first.
+  candidates.sort((a, b) => a.lastWriteTime - b.lastWriteTime);
+
+  const victims = new Map();
+  let bytesSelected = 0;
+  for (const candidate of candidates) {
+    if (bytesSelected >= bytesToFree) {
+      break;
+    }
+    bytesSelected += candidate.size;
+    if (!victims.has(candidate.cacheName)) {
+      victims.set(candidate.cacheName, []);
+    }
+    victims.get(candidate.cacheName).push(candidate);
+  }
+
+  let bytesFreed = 0;
+  for (const [ cacheName, list ] of victims) {
+    const stub = await acquireResource(resourceIdForCache(cacheName), /** exclusive */true);
+    try {
+      // The page may have been updated since it was scanned, only evict the
+      // entries that have not been re-written.
+      const kept = [];
+      const evicted = [];
+      for (const item of await readCachePageEntries(cacheName)) {
+        const victim = list.find(it => it.cacheObjectFilename === item.cache_object_filename &&
+          it.lastWriteTime === item.last_write_time);
+        (victim == null ? kept : evicted).push(item);
+      }
+      if (evicted.length === 0) {
+        continue;
+      }
+      await new Promise(resolve => binding.writeCachePage(cacheName, kept, resolve));
+      for (const item of evicted) {
+        await new Promise(resolve => binding.deleteCacheObjectPage(item.cache_object_filename, resolve));
+        debug('evicted %s, size: %d', item.cache_object_filename, item.size);
+        bytesFreed += item.size;
+      }
+    } finally {
+      stub.release();
+    }
+  }
+
+  if (bytesFreed > 0) {
+    await updateCacheStorageUsage(-bytesFreed);
+  }
+  return bytesFreed;
+}
+
+/**
+ * Resolves once the eviction in progress, if any, is done.
+ * @return {Promise<void>}
+ */
+async function waitForEviction() {
+  await evictionPromise;
+}
+
 function isOkStatus(status) {
   // eslint-disable-next-line yoda
   if (200 <= status && status <= 299) {
@@ -310,7 +528,6 @@ function batchCacheOperationsAtomicSteps(storage, operations) {
           storage.splice(idx, 1);
         }
       }
-      // TODO: check quota;
       debug('put request(%s %s)', op.request.method, op.request.url);
       storage.push([ op.request, op.response ]);
       addedItems.push([ op.request, op.response ]);
@@ -325,13 +542,15 @@ async function batchCacheOperations(cacheName, operations) {
     if (op.type === 'put' && op.response != null) {
       // Response should have been exhausted and no network operation is required.
       op.response[responseArrayBufferStoreKey] = await op.response.arrayBuffer();
+      op.response[responseLastWriteTimeKey] = Date.now();
     }
   }
 
   // Write op, exclusive.
-  const stub = await agentChannel.acquireResource(resourceIdForCache(cacheName), /** exclusive */true);
+  const stub = await acquireResource(resourceIdForCache(cacheName), /** exclusive */true);
   try {
     const storage = await readCacheFullStorage(cacheName, true);
+    const usageBytesBefore = cacheUsageBytes(storage);
     let resultList;
     try {
       resultList = batchCacheOperationsAtomicSteps(storage, operations);
@@ -340,6 +559,10 @@ async function batchCacheOperations(cacheName, operations) {
     }
     await writeCachePage(cacheName, storage);
     await Promise.allSettled(writeCacheObjectPages(cacheName, storage));
+    const delta = cacheUsageBytes(storage) - usageBytesBefore;
+    if (delta !== 0) {
+      await updateCacheStorageUsage(delta);
+    }
     return resultList;
   } finally {
     await stub.release();
@@ -559,7 +782,7 @@ class CacheStorage {
   async has(cacheName) {
     cachePreamble();
     cacheName = String(cacheName);
-    const resource = await agentChannel.acquireResource(resourceIdForCacheStorage(), /** exclusive */false);
+    const resource = await acquireResource(resourceIdForCacheStorage(), /** exclusive */false);
     try {
       return new Promise(resolve => {
         binding.detectCacheStorage(cacheName, exists => {
@@ -574,7 +797,7 @@ class CacheStorage {
   async open(cacheName) {
     cachePreamble();
     cacheName = String(cacheName);
-    const resource = await agentChannel.acquireResource(resourceIdForCacheStorage(), /** exclusive */true);
+    const resource = await acquireResource(resourceIdForCacheStorage(), /** exclusive */true);
     try {
       return new Promise(resolve => {
         binding.ensureCacheStorage(cacheName, () => {
@@ -590,21 +813,29 @@ class CacheStorage {
   async delete(cacheName) {
     cachePreamble();
     cacheName = String(cacheName);
-    const resource = await agentChannel.acquireResource(resourceIdForCacheStorage(), /** exclusive */true);
+    // The page of the cache is read and removed, lock it like any other write
+    // to the cache. Cache locks are taken before the storage lock, in the same
+    // order as the cache operations updating the storage usage.
+    const stub = await acquireResource(resourceIdForCache(cacheName), /** exclusive */true);
     try {
-      return new Promise(resolve => {
-        binding.deleteCacheStorage(cacheName, () => {
-          resolve();
+      const resource = await acquireResource(resourceIdForCacheStorage(), /** exclusive */true);
+      try {
+        return await new Promise(resolve => {
+          binding.deleteCacheStorage(cacheName, () => {
+            resolve();
+          });
         });
-      });
+      } finally {
+        resource.release();
+      }
     } finally {
-      resource.release();
+      stub.release();
     }
   }
 
   async keys() {
     cachePreamble();
-    const resource = await agentChannel.acquireResource(resourceIdForCacheStorage(), /** exclusive */false);
+    const resource = await acquireResource(resourceIdForCacheStorage(), /** exclusive */false);
     try {
       return new Promise(resolve => {
         binding.listCacheStorage(cacheNames => {
@@ -620,4 +851,5 @@ class CacheStorage {
 wrapper.mod = {
   Cache,
   CacheStorage,
+  waitForEviction,
 };
@@ -87,4 +87,5 @@ wrapper.mod = {
   abortSignal,
   createAbortSignal,
   createFollowingSignal,
+  isAbortSignal,
 };
@@ -3,13 +3,18 @@
 const curl = loadBinding('curl');
 const {
   Options,
+  MultiOptions,
   Codes,
   CurlMulti,
   CurlEasy,
   easyStrErr,
+  dnsLookup,
+  dnsPrewarm,
+  DnsResolveReq,
   CURLPAUSE_CONT,
-  CURL_READFUNC_PAUSE,
+  CURLPIPE_MULTIPLEX,
 } = curl;
+const options = loadBinding('aworker_options');
 
 const { addCleanupHook } = load('process/execution');
 const { createDeferred, bufferLikeToUint8Array } = load('utils');
@@ -21,6 +26,7 @@ const {
   setTimeout,
 } = load('timer');
 const { eventLoopUtilization } = load('performance/utils');
+const { URL } = load('url');
 
 const debug = debuglog('curl');
 
@@ -37,6 +43,10 @@ function getMulti() {
     initialized = true;
     curl.init();
     multi = new CurlMulti();
+    // Multiplex requests to the same HTTP/2 origin on one connection, and cap
+    // the HTTP/1.1 connections opened to a single host.
+    multi.setOpt(MultiOptions.CURLMOPT_PIPELINING, CURLPIPE_MULTIPLEX);
+    multi.setOpt(MultiOptions.CURLMOPT_MAX_HOST_CONNECTIONS, options.curl_max_host_connections);
     addCleanupHook(() => {
       multi.close();
       multi = null;
@@ -48,6 +58,53 @@ function getMulti() {
   return multi;
 }
 
+const kDefaultPorts = {
+  'http:': 80,
+  'https:': 443,
+};
+const kIpLiteralRE = /^(\[.*\]|\d+\.\d+\.\d+\.\d+)$/;
+
+function dnsResolve(hostname, port, ttl) {
+  const { promise, resolve } = createDeferred();
+  const req = new DnsResolveReq();
+  req._onComplete = resolve;
+  if (!req.resolve(hostname, port, ttl)) {
+    return undefined;
+  }
+  return promise;
+}
+
+/**
+ * Resolve the host name from the process-wide DNS cache, which is refreshed
+ * off the loop before the entries expire. Host names missing in the cache
+ * are resolved by the cache before the request is started, so that they are
+ * not resolved by curl again.
+ * @param {string} url -
+ * @return {Promise<string[]>} the CURLOPT_RESOLVE entries, empty if curl
+ *   should resolve the host name by itself.
+ */
+async function resolveFromCache(url) {
+  const { protocol, hostname, port } = new URL(url);
+  if (kIpLiteralRE.test(hostname)) {
+    return [];
+  }
+  const portNumber = port === '' ? kDefaultPorts[protocol] : Number.parseInt(port, 10);
+  if (portNumber == null) {
+    return [];
+  }
+  const ttl = options.curl_dns_cache_ttl_s * 1000;
+  let addresses = dnsLookup(hostname, portNumber, ttl);
+  if (addresses == null) {
+    addresses = await dnsResolve(hostname, portNumber, ttl);
+  }
+  // Let curl report the resolution failures.
+  if (addresses == null) {
+    return [];
+  }
+  // Entries prefixed with '+' time out like the resolved ones.
+  return [ `+${hostname}:${portNumber}:${addresses}` ];
+}
+
 function createCurlError(code, message) {
   const codeName = kCodeNameMap[code];
   const err = new TypeError(`Request failed (${codeName}): ${message}`);
@@ -113,9 +170,7 @@ class Curl {
 
   #body;
   #bodyReader;
-  #bodyBuffers = [];
   #bodyDone = false;
-  #bodyPaused = false;
 
   #elu = eventLoopUtilization();
   timingInfo = {
@@ -156,16 +211,11 @@ class Curl {
     this.#responseHeaderLines.push(line);
   };
 
-  #onRead = (nread, ab) => {
-    debug('handle onRead', nread);
-    const read = this.read(nread, new Uint8Array(ab));
-    debug('handle onRead done', read);
-    return read;
-  };
-
-  #onWrite = ab => {
-    debug('handle onWrite', ab.byteLength);
-    this.#responseBodyController.enqueue(ab);
+  #onWrite = abs => {
+    debug('handle onWrite', abs.length);
+    for (const ab of abs) {
+      this.#responseBodyController.enqueue(ab);
+    }
   };
 
   #onDone = (code, ...timingInfo) => {
@@ -221,12 +271,11 @@ class Curl {
     this.#handle = null;
   }
 
-  constructor(url, method, headers, body, signal) {
+  constructor(url, method, headers, body, signal, resolve, internalOptions) {
     const multi = getMulti();
     this.#handle = new CurlEasy();
     this.#handle._onPreReq = this.#onPreReq;
     this.#handle._onHeader = this.#onHeader;
-    this.#handle._onRead = this.#onRead;
     this.#handle._onWrite = this.#onWrite;
     this.#handle._onDone = this.#onDone;
 
@@ -236,7 +285,17 @@ class Curl {
 
     // Ignore proxy connect headers.
     this.#handle.setOpt(Options.CURLOPT_SUPPRESS_CONNECT_HEADERS, 1);
+    // Prefer waiting for a multiplexable connection over opening a new one.
+    this.#handle.setOpt(Options.CURLOPT_PIPEWAIT, 1);
+    this.#handle.setOpt(Options.CURLOPT_MAXAGE_CONN, options.curl_max_connection_idle_s);
     this.#handle.setOpt(Options.CURLOPT_URL, url);
+    this.#handle.setOpt(Options.CURLOPT_DNS_CACHE_TIMEOUT, options.curl_dns_cache_ttl_s);
+    if (resolve.length > 0) {
+      this.#handle.setOpt(Options.CURLOPT_RESOLVE, resolve);
+    }
+    if (internalOptions?.httpVersion != null) {
+      this.#handle.setOpt(Options.CURLOPT_HTTP_VERSION, internalOptions.httpVersion);
+    }
     const hasBody = body != null;
     this.setMethod(method, hasBody);
     this.setHeaders(headers);
@@ -299,13 +358,26 @@ class Curl {
   drainBody() {
     this.#bodyReader = this.#body.getReader();
     const drain = ({ done, value }) => {
+      if (this.#handle == null) {
+        // Request is either aborted or done.
+        return;
+      }
+      // The chunks are queued on the native handle and copied into curl's
+      // buffer directly. The handle reports if the transfer has been paused
+      // for the lack of request body.
+      let paused;
+      if (done) {
+        this.#bodyDone = true;
+        paused = this.#handle.endBody();
+      } else {
+        paused = this.#handle.writeBody(bufferLikeToUint8Array(value));
+      }
       // curl_easy_pause can invoke write callbacks synchronously, defer to
       // next loop tick.
       let unpause = Promise.resolve();
-      if (this.#bodyPaused) {
+      if (paused) {
         unpause = new Promise(resolve => {
           setTimeout(() => {
-            this.#bodyPaused = false;
             // If the #handle is null, request is either aborted or done.
             this.#handle?.pause(CURLPAUSE_CONT);
             resolve();
@@ -313,11 +385,8 @@ class Curl {
         });
       }
       if (done) {
-        this.#bodyDone = true;
         return unpause;
       }
-      const u8 = bufferLikeToUint8Array(value);
-      this.#bodyBuffers.push(u8);
       return unpause.then(() => this.#bodyReader.read()).then(drain);
     };
     this.#bodyReader.read()
@@ -329,47 +398,6 @@ class Curl {
       });
   }
 
-  /**
-   * @param {number} byteLength -
-   * @param {Uint8Array} target -
-   */
-  read(byteLength, target) {
-    if (byteLength === 0) {
-      return 0;
-    }
-    if (this.#bodyBuffers.length === 0) {
-      if (this.#bodyDone) {
-        return 0;
-      }
-      this.#bodyPaused = true;
-      return CURL_READFUNC_PAUSE;
-    }
-    let readByteLength = 0;
-    while (readByteLength < byteLength && this.#bodyBuffers.length) {
-      const next = this.#bodyBuffers.shift();
-      if (readByteLength + next.byteLength > byteLength) {
-        const toBeReadByteLength = byteLength - readByteLength;
-        const toBeReadView = new Uint8Array(next.buffer, next.byteOffset, toBeReadByteLength);
-        const remaining = new Uint8Array(next.buffer, next.byteOffset + toBeReadByteLength, next.byteLength - toBeReadByteLength);
-        target.set(toBeReadView, readByteLength);
-        this.#bodyBuffers.unshift(remaining);
-        readByteLength += toBeReadByteLength;
-        break;
-      }
-      target.set(next, readByteLength);
-      readByteLength += next.byteLength;
-    }
-
-    if (readByteLength !== 0) {
-      return readByteLength;
-    }
-    if (this.#bodyDone) {
-      return 0;
-    }
-    this.#bodyPaused = true;
-    return CURL_READFUNC_PAUSE;
-  }
-
   async getResponseHeader() {
     const ret = await this.#headerDeferred.promise;
     // MakeCallback drains microtask queue. CurlMulti cannot be invoked recursively.
@@ -379,9 +407,22 @@ class Curl {
   }
 }
 
-async function sendFetchReq(url, method, headers, body, signal) {
+/**
+ * @param {string} url -
+ * @param {string} method -
+ * @param {Headers} headers -
+ * @param {ReadableStream?} body -
+ * @param {AbortSignal?} signal -
+ * @param {{ httpVersion?: number }} [internalOptions] - internal options, e.g.
+ *   for benchmarks.
+ */
+async function sendFetchReq(url, method, headers, body, signal, internalOptions) {
   debug('request(url: %s, method: %s) with options', url, method, headers);
-  const request = new Curl(url, method, headers, body, signal);
+  const resolve = await resolveFromCache(url);
+  if (signal?.aborted) {
+    throw createAbortError();
+  }
+  const request = new Curl(url, method, headers, body, signal, resolve, internalOptions);
   const { status, statusText, headers: responseHeaders } = await request.getResponseHeader();
   debug('request(url: %s, method: %s) received response header', url, method, status, responseHeaders);
 
@@ -394,6 +435,30 @@ async function sendFetchReq(url, method, headers, body, signal) {
   };
 }
 
+// Build the process-wide certificate store and share handle, and resolve the
+// host names to be prewarmed ahead of time, e.g. before warm fork, so that
+// they are inherited by forked workers.
+function prewarm() {
+  debug('prewarm shared state');
+  curl.init();
+  if (options.has_curl_dns_prewarm) {
+    // Resolve synchronously, requests on the thread pool don't survive the
+    // fork.
+    for (const hostPort of options.curl_dns_prewarm.split(',')) {
+      const idx = hostPort.lastIndexOf(':');
+      if (idx <= 0) {
+        continue;
+      }
+      const host = hostPort.substring(0, idx).trim();
+      const port = Number.parseInt(hostPort.substring(idx + 1), 10);
+      const resolved = dnsPrewarm(host, port, options.curl_dns_cache_ttl_s * 1000);
+      debug('prewarm dns %s:%d', host, port, resolved);
+    }
+  }
+}
+
 wrapper.mod = {
+  prewarm,
+  resolveFromCache,
   sendFetchReq,
 };
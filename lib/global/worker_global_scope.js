@@ -28,6 +28,7 @@ const { PerformanceObserver, PerformanceObserverEntryList } = load('performance/
 const {
   navigator,
 } = load('navigator');
+const { scheduler, Scheduler } = load('scheduler');
 const {
   ReadableStream,
   WritableStream,
@@ -90,6 +91,7 @@ function InternalWorkerGlobalScope(self) {
     navigator,
     performance,
     queueMicrotask,
+    scheduler,
     setInterval,
     setTimeout,
 
@@ -116,6 +118,7 @@ function InternalWorkerGlobalScope(self) {
     ReadableStreamDefaultReader,
     Request,
     Response,
+    Scheduler,
     TextDecoder,
     TextEncoder,
     URL,
@@ -0,0 +1,101 @@
+'use strict';
+
+const {
+  SchedulerTaskWrap,
+  PRIORITY_USER_BLOCKING,
+  PRIORITY_USER_VISIBLE,
+  PRIORITY_BACKGROUND,
+} = loadBinding('scheduler');
+const { setTimeout, clearTimeout } = load('timer');
+const { createAbortError } = load('dom/exception');
+const { isAbortSignal } = load('dom/abort_signal');
+const { createDeferred } = load('utils');
+
+// Refer to: https://wicg.github.io/scheduling-apis/#enumdef-taskpriority
+const kPriorities = {
+  'user-blocking': PRIORITY_USER_BLOCKING,
+  'user-visible': PRIORITY_USER_VISIBLE,
+  background: PRIORITY_BACKGROUND,
+};
+
+const kConstructorKey = Symbol('Scheduler#constructor');
+
+/**
+ * See: https://wicg.github.io/scheduling-apis/#sec-scheduler
+ *
+ * Tasks are posted to the native macro task queue, which processes the tasks
+ * of higher priorities first.
+ */
+class Scheduler {
+  constructor(key) {
+    if (key !== kConstructorKey) {
+      throw new TypeError('Illegal constructor');
+    }
+  }
+
+  postTask(callback, options = {}) {
+    if (typeof callback !== 'function') {
+      return Promise.reject(new TypeError('Callback argument is invalid.'));
+    }
+    const { priority = 'user-visible', signal, delay = 0 } = options ?? {};
+    const nativePriority = kPriorities[priority];
+    if (typeof nativePriority !== 'number') {
+      return Promise.reject(new TypeError(`'${priority}' is not a valid task priority.`));
+    }
+    if (signal != null && !isAbortSignal(signal)) {
+      return Promise.reject(new TypeError('Option signal is not an AbortSignal.'));
+    }
+    if (signal?.aborted) {
+      return Promise.reject(createAbortError());
+    }
+
+    const { promise, resolve, reject } = createDeferred();
+    let timer = null;
+    let handle = null;
+    const onabort = () => {
+      if (timer !== null) {
+        clearTimeout(timer);
+        timer = null;
+      }
+      if (handle !== null) {
+        handle.abort();
+        handle = null;
+      }
+      reject(createAbortError());
+    };
+
+    const post = () => {
+      timer = null;
+      handle = new SchedulerTaskWrap(nativePriority);
+      handle.ontask = () => {
+        handle = null;
+        signal?.removeEventListener('abort', onabort);
+        try {
+          resolve(callback());
+        } catch (e) {
+          reject(e);
+        }
+      };
+    };
+
+    signal?.addEventListener('abort', onabort);
+    if (delay > 0) {
+      timer = setTimeout(post, delay);
+    } else {
+      post();
+    }
+    return promise;
+  }
+}
+
+Object.defineProperty(Scheduler.prototype, Symbol.toStringTag, {
+  configurable: true,
+  value: 'Scheduler',
+});
+
+const scheduler = new Scheduler(kConstructorKey);
+
+wrapper.mod = {
+  Scheduler,
+  scheduler,
+};
@@ -111,6 +111,9 @@ wrapper.mod = {
   promiseBeforeHook: asyncBefore,
   promiseAfterHook: asyncAfter,
 
+  asyncBefore,
+  asyncAfter,
+
   getExecutionResource,
   AsyncLocalStorage,
 };
@@ -3,16 +3,25 @@
 const timers = loadBinding('timers');
 const immediate = loadBinding('immediate');
 const taskQueue = loadBinding('task_queue');
+const process = loadBinding('process');
 const { console } = load('console');
+const {
+  asyncWrapInitFunction: asyncInit,
+  asyncBefore,
+  asyncAfter,
+  tickTaskQueue,
+} = load('task_queue');
 
 const TIMEOUT_MAX = 2 ** 31 - 1;
 
 const DESTROY = Symbol('Timeout#destroy');
 const SPIN = Symbol('Timeout#spin');
+const RUN_TIMER = Symbol('Timeout#run');
 const TIMERS = new Map();
 
 const IMMEDIATE_DESTROY = Symbol('Immediate#destroy');
 const RUN = Symbol('Immediate#run');
+const RUN_IMMEDIATE = Symbol('Immediate#runImmediate');
 const immediateMap = new Map();
 
 let seq = 0;
@@ -33,9 +42,199 @@ function formatDelay(delay) {
   return delay;
 }
 
-class Timeout {
-  #handle;
+/**
+ * Timers are kept in lists of the same duration, so that the timers in a list
+ * are ordered by their expiry. The lists are ordered by the expiry of their
+ * first timers in a binary heap, and a single native TimerWrap is scheduled
+ * to the earliest expiry.
+ *
+ * Refer to: https://github.com/nodejs/node/blob/cef1444/lib/internal/timers.js
+ */
+const timerLists = new Map();
+const timerListQueue = [];
+let timerHandle = null;
+let activeTimerCount = 0;
+let scheduledExpiry = Infinity;
+
+function compareTimerList(a, b) {
+  return a.expiry < b.expiry || (a.expiry === b.expiry && a.id < b.id);
+}
+
+function setTimerListPosition(pos, list) {
+  timerListQueue[pos] = list;
+  list.position = pos;
+}
+
+function percolateUp(pos) {
+  const list = timerListQueue[pos];
+  while (pos > 0) {
+    const parent = (pos - 1) >> 1;
+    if (!compareTimerList(list, timerListQueue[parent])) break;
+    setTimerListPosition(pos, timerListQueue[parent]);
+    pos = parent;
+  }
+  setTimerListPosition(pos, list);
+}
+
+function percolateDown(pos) {
+  const list = timerListQueue[pos];
+  const size = timerListQueue.length;
+  while (true) {
+    let child = pos * 2 + 1;
+    if (child >= size) break;
+    if (child + 1 < size && compareTimerList(timerListQueue[child + 1], timerListQueue[child])) {
+      child++;
+    }
+    if (!compareTimerList(timerListQueue[child], list)) break;
+    setTimerListPosition(pos, timerListQueue[child]);
+    pos = child;
+  }
+  setTimerListPosition(pos, list);
+}
+
+function removeTimerList(list) {
+  const last = timerListQueue.pop();
+  if (last !== list) {
+    setTimerListPosition(list.position, last);
+    percolateDown(list.position);
+    percolateUp(last.position);
+  }
+  timerLists.delete(list.duration);
+}
+
+/**
+ * Intrusive doubly linked list of timeouts or immediates.
+ */
+class LinkedList {
+  constructor() {
+    this.head = null;
+    this.tail = null;
+  }
+
+  append(item) {
+    item._prev = this.tail;
+    item._next = null;
+    if (this.tail === null) {
+      this.head = item;
+    } else {
+      this.tail._next = item;
+    }
+    this.tail = item;
+    item._list = this;
+  }
+
+  remove(item) {
+    if (item._prev === null) {
+      this.head = item._next;
+    } else {
+      item._prev._next = item._next;
+    }
+    if (item._next === null) {
+      this.tail = item._prev;
+    } else {
+      item._next._prev = item._prev;
+    }
+    item._prev = null;
+    item._next = null;
+    item._list = null;
+  }
+}
+
+let timerListSeq = 0;
+class TimerList extends LinkedList {
+  constructor(duration, expiry) {
+    super();
+    this.id = timerListSeq++;
+    this.duration = duration;
+    this.expiry = expiry;
+    this.position = -1;
+  }
+}
+
+function getTimerHandle() {
+  if (timerHandle === null) {
+    timerHandle = new timers.TimerWrap();
+    timerHandle.ontimeout = processTimers;
+  }
+  return timerHandle;
+}
+
+function scheduleTimerHandle(expiry, now) {
+  if (expiry === scheduledExpiry) return;
+  scheduledExpiry = expiry;
+  getTimerHandle().schedule(expiry - now);
+}
+
+function insertTimer(timer, start) {
+  const duration = timer._delay;
+  timer._expiry = start + duration;
+  let list = timerLists.get(duration);
+  if (list === undefined) {
+    list = new TimerList(duration, timer._expiry);
+    timerLists.set(duration, list);
+    timerListQueue.push(list);
+    percolateUp(timerListQueue.length - 1);
+  }
+  list.append(timer);
+  if (list.position === 0) {
+    scheduleTimerHandle(list.expiry, start);
+  }
+}
+
+function refTimerHandle() {
+  if (activeTimerCount++ === 0) {
+    getTimerHandle().ref();
+  }
+}
+
+function unrefTimerHandle() {
+  if (--activeTimerCount === 0) {
+    // Emptied lists are kept in the queue until their expiry, don't let them
+    // keep the event loop alive.
+    timerHandle.unref();
+  }
+}
+
+function processTimers(now) {
+  scheduledExpiry = Infinity;
+  let list;
+  while ((list = timerListQueue[0]) !== undefined) {
+    if (list.expiry > now) {
+      scheduleTimerHandle(list.expiry, now);
+      return;
+    }
+    listOnTimeout(list, now);
+  }
+  timerHandle.stop();
+}
 
+function listOnTimeout(list, now) {
+  let timer;
+  while ((timer = list.head) !== null) {
+    if (timer._expiry > now) {
+      list.expiry = timer._expiry;
+      percolateDown(list.position);
+      return;
+    }
+    list.remove(timer);
+    if (timer._loop) {
+      insertTimer(timer, now);
+    }
+    // Timers may throw, the remaining timers are processed in the next call
+    // from native. Each timer is watched as a task of its own by the loop
+    // latency watchdog.
+    process.loopLatencyWatchdogPrologue();
+    try {
+      timer[RUN_TIMER]();
+      tickTaskQueue();
+    } finally {
+      process.loopLatencyWatchdogEpilogue();
+    }
+  }
+  removeTimerList(list);
+}
+
+class Timeout {
   constructor(group, loop, func, delay, ...args) {
     if (typeof func !== 'function') {
       throw new Error('Callback argument is invalid.');
@@ -46,27 +245,38 @@ class Timeout {
     this._group = group;
     this._loop = loop;
     this._onTimeout = func;
-    this._delay = formatDelay(delay);
+    this._delay = Math.trunc(formatDelay(delay));
     this._args = args;
+
+    this._expiry = 0;
+    this._list = null;
+    this._prev = null;
+    this._next = null;
+    // The timeout is the async resource of its callbacks.
+    asyncInit(this);
   }
 
-  #ontimeout = () => {
+  [RUN_TIMER]() {
+    const onTimeout = this._onTimeout;
+    const args = this._args;
+    if (!this._loop) {
+      this[DESTROY]();
+    }
+    asyncBefore(this);
     try {
-      this._onTimeout(...this._args);
+      Reflect.apply(onTimeout, this, args);
     } finally {
-      if (!this._loop) {
-        this[DESTROY]();
-      }
+      asyncAfter();
     }
-  };
+  }
 
   [SPIN]() {
     if (this._spinning || this._destroyed) return;
     this._id = seq++;
-    this.#handle = new timers.TimerWrap(this._delay, this._loop);
-    this.#handle.ontimeout = this.#ontimeout;
     this._group.set(this._id, this);
     this._spinning = true;
+    insertTimer(this, timers.getLibuvNow());
+    refTimerHandle();
     return this._id;
   }
 
@@ -75,8 +285,10 @@ class Timeout {
     if (typeof this._id !== 'number') return;
     if (!this._group.has(this._id)) return;
     this._group.delete(this._id);
-    this.#handle.remove();
-    this.#handle = null;
+    if (this._list !== null) {
+      this._list.remove(this);
+    }
+    unrefTimerHandle();
 
     this._group = null;
     this._loop = false;
@@ -92,8 +304,63 @@ class Timeout {
   }
 }
 
+/**
+ * Immediates are queued in JavaScript, and the queue is drained in one
+ * callback of the single native ImmediateWrap. Immediates queued while
+ * draining are run in the next loop iteration.
+ */
+let immediateQueue = new LinkedList();
+let outstandingImmediateQueue = null;
+let immediateHandle = null;
+let immediateRefCount = 0;
+
+function getImmediateHandle() {
+  if (immediateHandle === null) {
+    immediateHandle = new immediate.ImmediateWrap();
+    immediateHandle.onimmediate = processImmediate;
+  }
+  return immediateHandle;
+}
+
+function processImmediate() {
+  // If an immediate threw, the remaining immediates of the drained queue are
+  // processed in the next call from native.
+  const queue = outstandingImmediateQueue ?? immediateQueue;
+  if (queue === immediateQueue) {
+    immediateQueue = new LinkedList();
+  }
+  outstandingImmediateQueue = queue;
+
+  let imm;
+  while ((imm = queue.head) !== null) {
+    process.loopLatencyWatchdogPrologue();
+    try {
+      imm[RUN_IMMEDIATE]();
+      tickTaskQueue();
+    } finally {
+      process.loopLatencyWatchdogEpilogue();
+    }
+  }
+  outstandingImmediateQueue = null;
+
+  if (immediateQueue.head !== null) {
+    immediateHandle.schedule();
+  }
+}
+
+function refImmediateHandle() {
+  if (immediateRefCount++ === 0) {
+    getImmediateHandle().ref();
+  }
+}
+
+function unrefImmediateHandle() {
+  if (--immediateRefCount === 0) {
+    immediateHandle.unref();
+  }
+}
+
 class Immediate {
-  #handle;
   constructor(callback, ...args) {
     if (typeof callback !== 'function') {
       throw new Error('Callback argument is invalid.');
@@ -102,21 +369,33 @@ class Immediate {
     this._args = args;
     this._destroyed = false;
     this._onimmediate = callback;
+    this._refed = false;
+
+    this._list = null;
+    this._prev = null;
+    this._next = null;
+    // The immediate is the async resource of its callback.
+    asyncInit(this);
   }
 
-  #onimmediate = () => {
+  [RUN_IMMEDIATE]() {
+    const onimmediate = this._onimmediate;
+    const args = this._args;
+    this[IMMEDIATE_DESTROY]();
+    asyncBefore(this);
     try {
-      this._onimmediate(...this._args);
+      Reflect.apply(onimmediate, this, args);
     } finally {
-      this[IMMEDIATE_DESTROY]();
+      asyncAfter();
     }
-  };
+  }
 
   [RUN]() {
     this._id = immediateSeq++;
-    this.#handle = new immediate.ImmediateWrap();
-    this.#handle.onimmediate = this.#onimmediate;
     immediateMap.set(this._id, this);
+    immediateQueue.append(this);
+    this.ref();
+    getImmediateHandle().schedule();
     return this._id;
   }
 
@@ -125,13 +404,33 @@ class Immediate {
     if (typeof this._id !== 'number') return;
     if (!immediateMap.has(this._id)) return;
     immediateMap.delete(this._id);
-    this.#handle.remove();
-    this.#handle = null;
+    this._list.remove(this);
+    this.unref();
     this._onimmediate = null;
     this._args = null;
     this._destroyed = true;
   }
 
+  ref() {
+    if (!this._refed && !this._destroyed) {
+      this._refed = true;
+      refImmediateHandle();
+    }
+    return this;
+  }
+
+  unref() {
+    if (this._refed) {
+      this._refed = false;
+      unrefImmediateHandle();
+    }
+    return this;
+  }
+
+  hasRef() {
+    return this._refed;
+  }
+
   toString() {
     return this._id === null ? 'null' : this._id.toString();
   }
@@ -182,7 +481,7 @@ function clearInterval(id) {
 }
 
 function clearImmediate(id) {
-  if (!id instanceof Immediate) {
+  if (!(id instanceof Immediate)) {
     if (!immediateMap.has(id)) return false;
     id = immediateMap.get(id);
   }
@@ -9,6 +9,8 @@ const {
   UnzipWrapper,
   WINDOWBITS,
   ZipWrapper,
+  compressSync: _compressSync,
+  decompressSync: _decompressSync,
 } = loadBinding('zlib');
 
 const { createDeferred, toArrayBuffer } = load('utils');
@@ -84,27 +86,54 @@ class ZlibWrapper extends TransformStream {
   }
 }
 
-class Zip extends ZlibWrapper {
-  constructor(type, options = {}) {
-    checkRange('type', type, COMPRESS_TYPE.GZIP, COMPRESS_TYPE.DEFLATE);
+function normalizeZipOptions(type, options) {
+  checkRange('type', type, COMPRESS_TYPE.GZIP, COMPRESS_TYPE.DEFLATE);
 
-    const _options = {
-      ...defaultOptions,
-      ...options,
-    };
+  const _options = {
+    ...defaultOptions,
+    ...options,
+  };
 
-    {
-      const min = WINDOWBITS.Z_MIN_WINDOWBITS + (type === COMPRESS_TYPE.GZIP ? 1 : 0);
-      checkRange(
-        'options.windowBits',
-        _options.windowBits,
-        min,
-        WINDOWBITS.Z_MAX_WINDOWBITS);
-    }
+  {
+    const min = WINDOWBITS.Z_MIN_WINDOWBITS + (type === COMPRESS_TYPE.GZIP ? 1 : 0);
+    checkRange(
+      'options.windowBits',
+      _options.windowBits,
+      min,
+      WINDOWBITS.Z_MAX_WINDOWBITS);
+  }
+
+  checkRange('options.level', _options.level, LEVEL.Z_MIN_LEVEL, LEVEL.Z_MAX_LEVEL);
+  checkRange('options.memLevel', _options.memLevel, LEVEL.Z_MIN_MEMLEVEL, LEVEL.Z_MAX_MEMLEVEL);
+  checkRange('options.strategy', _options.strategy, STRATEGY.Z_DEFAULT_STRATEGY, STRATEGY.Z_FIXED);
+
+  return _options;
+}
+
+function normalizeUnzipOptions(type, options) {
+  checkRange('type', type, UNCOMPRESS_TYPE.GUNZIP, UNCOMPRESS_TYPE.UNZIP);
+
+  const _options = {
+    ...defaultOptions,
+    ...options,
+  };
+
+  if (options.windowBits === 0 || options.windowBits === null) {
+    _options.windowBits = 0;
+  } else {
+    checkRange(
+      'options.windowBits',
+      _options.windowBits,
+      WINDOWBITS.Z_MIN_WINDOWBITS,
+      WINDOWBITS.Z_MAX_WINDOWBITS);
+  }
 
-    checkRange('options.level', _options.level, LEVEL.Z_MIN_LEVEL, LEVEL.Z_MAX_LEVEL);
-    checkRange('options.memLevel', _options.memLevel, LEVEL.Z_MIN_MEMLEVEL, LEVEL.Z_MAX_MEMLEVEL);
-    checkRange('options.strategy', _options.strategy, STRATEGY.Z_DEFAULT_STRATEGY, STRATEGY.Z_FIXED);
+  return _options;
+}
+
+class Zip extends ZlibWrapper {
+  constructor(type, options = {}) {
+    const _options = normalizeZipOptions(type, options);
 
     super(type, _options, {
       flush: controller => this.#flush(controller),
@@ -143,22 +172,7 @@ class Zip extends ZlibWrapper {
 
 class Unzip extends ZlibWrapper {
   constructor(type, options = {}) {
-    checkRange('type', type, UNCOMPRESS_TYPE.GUNZIP, UNCOMPRESS_TYPE.UNZIP);
-
-    const _options = {
-      ...defaultOptions,
-      ...options,
-    };
-
-    if (options.windowBits === 0 || options.windowBits === null) {
-      _options.windowBits = 0;
-    } else {
-      checkRange(
-        'options.windowBits',
-        _options.windowBits,
-        WINDOWBITS.Z_MIN_WINDOWBITS,
-        WINDOWBITS.Z_MAX_WINDOWBITS);
-    }
+    const _options = normalizeUnzipOptions(type, options);
 
     checkRange(
       'options.flush',
@@ -184,9 +198,37 @@ class Unzip extends ZlibWrapper {
   }
 }
 
+/**
+ * Compresses the whole `data` in one zlib call on the calling thread.
+ * @param {number} type COMPRESS_TYPE
+ * @param {string|ArrayBuffer|ArrayBufferView} data
+ * @param {object} [options]
+ * @returns {ArrayBuffer}
+ */
+function compressSync(type, data, options = {}) {
+  const _options = normalizeZipOptions(type, options);
+  const { buff, offset, length } = toArrayBuffer(data);
+  return _compressSync(type, buff, offset, length, _options.windowBits, _options);
+}
+
+/**
+ * Decompresses the whole `data` on the calling thread.
+ * @param {number} type UNCOMPRESS_TYPE
+ * @param {ArrayBuffer|ArrayBufferView} data
+ * @param {object} [options]
+ * @returns {ArrayBuffer}
+ */
+function decompressSync(type, data, options = {}) {
+  const _options = normalizeUnzipOptions(type, options);
+  const { buff, offset, length } = toArrayBuffer(data);
+  return _decompressSync(type, buff, offset, length, _options.windowBits);
+}
+
 mod.COMPRESS_TYPE = COMPRESS_TYPE;
 mod.UNCOMPRESS_TYPE = UNCOMPRESS_TYPE;
 mod.FLUSH_MODE = FLUSH_MODE;
 mod.STRATEGY = STRATEGY;
 mod.Unzip = Unzip;
 mod.Zip = Zip;
+mod.compressSync = compressSync;
+mod.decompressSync = decompressSync;
@@ -1,7 +1,9 @@
 #include "agent_channel/noslated_data_channel.h"
 #include <unistd.h>
 #include <string>
+#include "array_buffer_allocator.h"
 #include "aworker_logger.h"
+#include "binding/curl/curl_statistics.h"
 #include "command_parser.h"
 #include "debug_utils.h"
 #include "error_handling.h"
@@ -383,6 +385,56 @@ void NoslatedDataChannel::CollectMetrics(
 #undef V
 #undef HEAP_STATISTICS_FIELDS_FOREACH
 
+  const curl::ConnectionStatistics& conn_stats =
+      curl::GetConnectionStatistics();
+  double reuse_ratio =
+      conn_stats.transfers == 0
+          ? 0
+          : static_cast<double>(conn_stats.reused_transfers) /
+                conn_stats.transfers;
+#define CURL_CONNECTION_STATISTICS_FOREACH(V)                                  \
+  V(curl_transfers, conn_stats.transfers)                                      \
+  V(curl_new_connections, conn_stats.new_connections)                          \
+  V(curl_connection_reuse_ratio, reuse_ratio)
+
+#define V(name, value)                                                         \
+  {                                                                            \
+    auto record = res->add_integer_records();                                  \
+    record->set_name("noslate.worker." #name);                                 \
+    auto label = record->add_labels();                                         \
+    label->set_key("noslate.worker.pid");                                      \
+    label->set_value(std::to_string(getpid()));                                \
+    record->set_value(value);                                                  \
+  }
+  CURL_CONNECTION_STATISTICS_FOREACH(V)
+
+#undef CURL_CONNECTION_STATISTICS_FOREACH
+
+  const Immortal::LoopStatistics* loop_stats = immortal_->loop_statistics();
+#define LOOP_STATISTICS_FOREACH(V)                                             \
+  V(loop_wakeups, loop_stats->wakeups)                                         \
+  V(loop_timer_wakeups, loop_stats->timer_wakeups)
+
+  LOOP_STATISTICS_FOREACH(V)
+
+#undef LOOP_STATISTICS_FOREACH
+
+  ArrayBufferAllocator* allocator = ArrayBufferAllocator::From(isolate);
+  if (allocator != nullptr) {
+    ArrayBufferAllocator::Statistics ab_stats = allocator->GetStatistics();
+#define ARRAY_BUFFER_ALLOCATOR_STATISTICS_FOREACH(V)                           \
+  V(array_buffer_allocations, ab_stats.allocations)                            \
+  V(array_buffer_pooled_allocations, ab_stats.pooled_allocations)              \
+  V(array_buffer_allocated_bytes, ab_stats.allocated_bytes)                    \
+  V(array_buffer_pooled_bytes, ab_stats.pooled_bytes)
+
+    ARRAY_BUFFER_ALLOCATOR_STATISTICS_FOREACH(V)
+
+#undef ARRAY_BUFFER_ALLOCATOR_STATISTICS_FOREACH
+  }
+
+#undef V
+
   closure(CanonicalCode::OK, nullptr, move(res));
 }
 
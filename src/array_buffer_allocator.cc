@@ -0,0 +1,138 @@
+#include "array_buffer_allocator.h"
+#include <cstdlib>
+#include <cstring>
+
+#include "utils/async_primitives.h"
+
+namespace aworker {
+
+namespace {
+// Depth of the NoZeroFillScope on the current thread.
+thread_local int no_zero_fill_depth = 0;
+}  // namespace
+
+ArrayBufferAllocator::NoZeroFillScope::NoZeroFillScope() {
+  no_zero_fill_depth++;
+}
+
+ArrayBufferAllocator::NoZeroFillScope::~NoZeroFillScope() {
+  no_zero_fill_depth--;
+}
+
+// All the isolates with an allocator are created with the platform allocator.
+ArrayBufferAllocator* ArrayBufferAllocator::From(v8::Isolate* isolate) {
+  return static_cast<ArrayBufferAllocator*>(isolate->GetArrayBufferAllocator());
+}
+
+ArrayBufferAllocator::~ArrayBufferAllocator() {
+  for (SizeClass& size_class : size_classes_) {
+    FreeNode* node = size_class.head;
+    while (node != nullptr) {
+      FreeNode* next = node->next;
+      free(node);
+      node = next;
+    }
+  }
+}
+
+size_t ArrayBufferAllocator::SizeClassIndex(size_t length) {
+  size_t index = 0;
+  size_t size = kMinPooledSize;
+  while (size < length) {
+    size <<= 1;
+    index++;
+  }
+  return index;
+}
+
+void* ArrayBufferAllocator::Allocate(size_t length) {
+  return DoAllocate(length, no_zero_fill_depth == 0);
+}
+
+void* ArrayBufferAllocator::AllocateUninitialized(size_t length) {
+  return DoAllocate(length, false);
+}
+
+void* ArrayBufferAllocator::DoAllocate(size_t length, bool zero_fill) {
+  allocations_.fetch_add(1, std::memory_order_relaxed);
+  if (length == 0 || length > kMaxPooledSize) {
+    void* data = zero_fill ? calloc(length, 1) : malloc(length);
+    if (data != nullptr) {
+      allocated_bytes_.fetch_add(length, std::memory_order_relaxed);
+    }
+    return data;
+  }
+
+  size_t index = SizeClassIndex(length);
+  size_t size = kMinPooledSize << index;
+  SizeClass& size_class = size_classes_[index];
+  FreeNode* node;
+  {
+    ScopedLock lock(size_class.mutex);
+    node = size_class.head;
+    if (node != nullptr) {
+      size_class.head = node->next;
+      size_class.pooled_bytes -= size;
+    }
+  }
+
+  void* data;
+  if (node != nullptr) {
+    pooled_allocations_.fetch_add(1, std::memory_order_relaxed);
+    pooled_bytes_.fetch_sub(size, std::memory_order_relaxed);
+    data = node;
+    if (zero_fill) {
+      memset(data, 0, length);
+    }
+  } else {
+    // Allocate the whole size class so that the buffer can be recycled for
+    // any length of the class.
+    data = zero_fill ? calloc(size, 1) : malloc(size);
+    if (data == nullptr) {
+      return nullptr;
+    }
+  }
+  allocated_bytes_.fetch_add(length, std::memory_order_relaxed);
+  return data;
+}
+
+void ArrayBufferAllocator::Free(void* data, size_t length) {
+  if (data == nullptr) {
+    return;
+  }
+  allocated_bytes_.fetch_sub(length, std::memory_order_relaxed);
+  if (length == 0 || length > kMaxPooledSize) {
+    free(data);
+    return;
+  }
+
+  size_t index = SizeClassIndex(length);
+  size_t size = kMinPooledSize << index;
+  SizeClass& size_class = size_classes_[index];
+  {
+    ScopedLock lock(size_class.mutex);
+    if (size_class.pooled_bytes + size <= kMaxPooledBytesPerClass) {
+      FreeNode* node = static_cast<FreeNode*>(data);
+      node->next = size_class.head;
+      size_class.head = node;
+      size_class.pooled_bytes += size;
+      data = nullptr;
+    }
+  }
+  if (data != nullptr) {
+    free(data);
+    return;
+  }
+  pooled_bytes_.fetch_add(size, std::memory_order_relaxed);
+}
+
+ArrayBufferAllocator::Statistics ArrayBufferAllocator::GetStatistics() const {
+  return {
+      allocations_.load(std::memory_order_relaxed),
+      pooled_allocations_.load(std::memory_order_relaxed),
+      allocated_bytes_.load(std::memory_order_relaxed),
+      pooled_bytes_.load(std::memory_order_relaxed),
+  };
+}
+
+}  // namespace aworker
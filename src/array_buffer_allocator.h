@@ -0,0 +1,94 @@
+#ifndef SRC_ARRAY_BUFFER_ALLOCATOR_H_
+#define SRC_ARRAY_BUFFER_ALLOCATOR_H_
+
+#include <atomic>
+#include <mutex>  // NOLINT(build/c++11)
+
+#include "util.h"
+#include "v8.h"
+
+namespace aworker {
+
+/**
+ * ArrayBuffer allocator keeping the freed small buffers in per size class
+ * freelists, so that the short-living buffers (IPC chunks, encoded strings,
+ * network chunks, etc.) are recycled without hitting malloc.
+ *
+ * The size classes are powers of two from kMinPooledSize to kMaxPooledSize,
+ * larger buffers are allocated with the libc allocator directly. Each
+ * freelist retains at most kMaxPooledBytesPerClass bytes.
+ */
+class ArrayBufferAllocator : public v8::ArrayBuffer::Allocator {
+ public:
+  static constexpr size_t kMinPooledSize = 64;
+  static constexpr size_t kMaxPooledSize = 64 * 1024;
+  static constexpr size_t kMaxPooledBytesPerClass = 1024 * 1024;
+
+  struct Statistics {
+    // Count of the allocations.
+    size_t allocations;
+    // Count of the allocations served from the freelists.
+    size_t pooled_allocations;
+    // Bytes of the buffers not freed yet.
+    size_t allocated_bytes;
+    // Bytes of the buffers retained in the freelists.
+    size_t pooled_bytes;
+  };
+
+  /**
+   * Skip zero filling the buffers allocated with `Allocate` on the current
+   * thread while the scope is alive, for the bindings that overwrite the
+   * whole buffer immediately after `v8::ArrayBuffer::New`.
+   */
+  class NoZeroFillScope {
+   public:
+    NoZeroFillScope();
+    ~NoZeroFillScope();
+    AWORKER_DISALLOW_ASSIGN_COPY(NoZeroFillScope);
+  };
+
+  /**
+   * Get the allocator of the isolate, or nullptr if the isolate is not
+   * created with an allocator, e.g. the isolates of the snapshot creator.
+   */
+  static ArrayBufferAllocator* From(v8::Isolate* isolate);
+
+  ArrayBufferAllocator() = default;
+  ~ArrayBufferAllocator() override;
+  AWORKER_DISALLOW_ASSIGN_COPY(ArrayBufferAllocator);
+
+  void* Allocate(size_t length) override;
+  void* AllocateUninitialized(size_t length) override;
+  void Free(void* data, size_t length) override;
+
+  Statistics GetStatistics() const;
+
+ private:
+  struct FreeNode {
+    FreeNode* next;
+  };
+
+  struct SizeClass {
+    std::mutex mutex;
+    FreeNode* head = nullptr;
+    size_t pooled_bytes = 0;
+  };
+
+  static constexpr size_t kSizeClassCount = 11;
+  static_assert(kMinPooledSize << (kSizeClassCount - 1) == kMaxPooledSize,
+                "size classes must cover [kMinPooledSize, kMaxPooledSize]");
+
+  static size_t SizeClassIndex(size_t length);
+  void* DoAllocate(size_t length, bool zero_fill);
+
+  SizeClass size_classes_[kSizeClassCount];
+
+  std::atomic<size_t> allocations_{0};
+  std::atomic<size_t> pooled_allocations_{0};
+  std::atomic<size_t> allocated_bytes_{0};
+  std::atomic<size_t> pooled_bytes_{0};
+};
+
+}  // namespace aworker
+
+#endif  // SRC_ARRAY_BUFFER_ALLOCATOR_H_
@@ -24,6 +24,7 @@
   V(module_wrap)                                                               \
   V(perf)                                                                      \
   V(process)                                                                   \
+  V(scheduler)                                                                 \
   V(serdes)                                                                    \
   V(signals)                                                                   \
   V(task_queue)                                                                \
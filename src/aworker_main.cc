@@ -32,7 +32,8 @@ int main(int argc, char** argv) {
     AworkerPlatform platform(cli->threaded_platform()
                                  ? AworkerPlatform::kMultiThread
                                  : AworkerPlatform::kSingleThread,
-                             cli->threaded_platform_pool_size());
+                             cli->threaded_platform_pool_size(),
+                             cli->threaded_platform_affinity());
     AworkerPlatform::Scope use_platform(&platform);
     v8::V8::Initialize();
     {
@@ -1,3 +1,4 @@
+#include <algorithm>
 #include <cmath>
 
 #include "aworker_platform.h"
@@ -30,6 +31,36 @@ namespace {
 inline uint64_t now_in_ms() {
   return uv_hrtime() / 1000 / 1000;
 }
+
+// Max duration of an idle period, so that the pending idle tasks never block
+// the loop for too long if there is no timer at all.
+constexpr int kMaxIdlePeriodMs = 50;
+
+double MonotonicTimeInSeconds() {
+#ifdef __APPLE__
+  static bool inited = false;
+  static uint64_t (*time_func)(void);
+  static mach_timebase_info_data_t timebase;
+
+  if (!inited) {
+    CHECK_EQ(mach_timebase_info(&timebase), KERN_SUCCESS);
+    time_func = (uint64_t(*)(void))dlsym(RTLD_DEFAULT, "mach_continuous_time");
+    if (time_func == nullptr) time_func = mach_absolute_time;
+    inited = true;
+  }
+
+  return (time_func() * timebase.numer / timebase.denom) / 1e9;  // NOLINT
+#else
+  struct timespec t;
+  clock_t clock_id;
+
+  clock_id = CLOCK_MONOTONIC;
+
+  if (clock_gettime(clock_id, &t)) return 0; /* Not really possible. */
+
+  return (t.tv_sec * (uint64_t)1e9 + t.tv_nsec) / 1e9;
+#endif
+}
 }  // namespace
 
 // Ensures that __metadata trace events are only emitted
@@ -102,17 +133,54 @@ void ForegroundTaskRunner::ImmediateProcessor(uv_async_t* async) {
   runner->RunTasks();
 }
 
+// static
+void ForegroundTaskRunner::IdleProcessor(uv_prepare_t* prepare) {
+  ForegroundTaskRunner* runner =
+      ContainerOf(&ForegroundTaskRunner::prepare_, prepare);
+  runner->RunIdleTasks();
+}
+
+void ForegroundTaskRunner::RunIdleTasks() {
+  // Idle tasks posted while running the idle tasks are run in the next idle
+  // period.
+  while (PlatformIdleTask* task = idle_tasks_.Pop()) {
+    pending_idle_tasks_.emplace_back(task);
+  }
+  if (pending_idle_tasks_.empty()) {
+    return;
+  }
+
+  // The loop is not going to be idle if there are pending events.
+  int timeout = uv_backend_timeout(prepare_.loop);
+  if (timeout == 0) {
+    return;
+  }
+  if (timeout < 0 || timeout > kMaxIdlePeriodMs) {
+    timeout = kMaxIdlePeriodMs;
+  }
+  double deadline = MonotonicTimeInSeconds() + timeout / 1e3;
+
+  TRACE_EVENT0(TRACING_CATEGORY_AWORKER1(platform), "RunIdleTasks");
+  while (!pending_idle_tasks_.empty() && MonotonicTimeInSeconds() < deadline) {
+    std::unique_ptr<PlatformIdleTask> task =
+        std::move(pending_idle_tasks_.front());
+    pending_idle_tasks_.pop_front();
+    task->Run(deadline);
+  }
+  per_process::Debug(DebugCategory::PLATFORM,
+                     "ran idle tasks in %dms period, pending: %d\n",
+                     timeout,
+                     pending_idle_tasks_.size());
+}
+
 void ForegroundTaskRunner::RunTasks() {
   DrainTasks();
 
   uint64_t now = now_in_ms();
   uint64_t next_timeout = 0;
-  {
-    std::scoped_lock guard(queue_mutex_);
-    if (delayed_tasks_.size() > 0) {
-      next_timeout =
-          std::max(delayed_tasks_.top()->deadline() - now, uint64_t(1));
-    }
+  if (delayed_tasks_.size() > 0) {
+    uint64_t deadline = delayed_tasks_.top()->deadline();
+    next_timeout = deadline > now ? deadline - now : 1;
   }
   if (next_timeout == 0) {
     uv_timer_stop(&timer_);
@@ -125,20 +193,24 @@ void ForegroundTaskRunner::RunTasks() {
 
 void ForegroundTaskRunner::DrainTasks() {
   uint64_t now = now_in_ms();
-  std::list<std::unique_ptr<PlatformTask>> tasks;
-  std::list<std::unique_ptr<PlatformDelayedTask>> delayed_tasks;
-  {
-    std::scoped_lock guard(queue_mutex_);
-    tasks_.swap(tasks);
-    while (delayed_tasks_.size() > 0) {
-      auto& it = const_cast<std::unique_ptr<PlatformDelayedTask>&>(
-          delayed_tasks_.top());
-      if (it->deadline() > now) {
-        break;
-      }
-      delayed_tasks.push_back(std::move(it));
-      delayed_tasks_.pop();
+  // Tasks posted while running the popped tasks are run in the next round.
+  std::vector<std::unique_ptr<PlatformTask>> tasks;
+  std::vector<std::unique_ptr<PlatformTask>> delayed_tasks;
+  while (PlatformTask* task = tasks_.Pop()) {
+    if (task->deadline() == PlatformTask::kNoDeadline) {
+      tasks.emplace_back(task);
+    } else {
+      delayed_tasks_.emplace(task);
+    }
+  }
+  while (delayed_tasks_.size() > 0) {
+    auto& it =
+        const_cast<std::unique_ptr<PlatformTask>&>(delayed_tasks_.top());
+    if (it->deadline() > now) {
+      break;
     }
+    delayed_tasks.push_back(std::move(it));
+    delayed_tasks_.pop();
   }
   for (auto& it : tasks) {
     it->Run();
@@ -151,11 +223,21 @@ void ForegroundTaskRunner::DrainTasks() {
 ForegroundTaskRunner::ForegroundTaskRunner(uv_loop_t* loop) {
   uv_timer_init(loop, &timer_);
   uv_async_init(loop, &async_, ImmediateProcessor);
+  uv_prepare_init(loop, &prepare_);
+  uv_prepare_start(&prepare_, IdleProcessor);
   uv_unref(reinterpret_cast<uv_handle_t*>(&timer_));
   uv_unref(reinterpret_cast<uv_handle_t*>(&async_));
+  uv_unref(reinterpret_cast<uv_handle_t*>(&prepare_));
 }
 
-ForegroundTaskRunner::~ForegroundTaskRunner() {}
+ForegroundTaskRunner::~ForegroundTaskRunner() {
+  while (PlatformTask* task = tasks_.Pop()) {
+    delete task;
+  }
+  while (PlatformIdleTask* task = idle_tasks_.Pop()) {
+    delete task;
+  }
+}
 
 void ForegroundTaskRunner::Delete(ForegroundTaskRunner* runner) {
   uv_close(reinterpret_cast<uv_handle_t*>(&runner->async_),
@@ -168,28 +250,36 @@ void ForegroundTaskRunner::Delete(ForegroundTaskRunner* runner) {
                         ForegroundTaskRunner* runner =
                             ContainerOf(&ForegroundTaskRunner::timer_,
                                         reinterpret_cast<uv_timer_t*>(handle));
-                        delete runner;
+                        uv_close(
+                            reinterpret_cast<uv_handle_t*>(&runner->prepare_),
+                            [](uv_handle_t* handle) {
+                              ForegroundTaskRunner* runner = ContainerOf(
+                                  &ForegroundTaskRunner::prepare_,
+                                  reinterpret_cast<uv_prepare_t*>(handle));
+                              delete runner;
+                            });
                       });
            });
 }
 
-void ForegroundTaskRunner::PostTask(unique_ptr<v8::Task> task) {
-  {
-    std::scoped_lock guard(queue_mutex_);
-    tasks_.push_back(std::make_unique<PlatformTask>(move(task)));
-  }
+void ForegroundTaskRunner::Post(unique_ptr<PlatformTask> task) {
+  tasks_.Push(task.release());
   uv_async_send(&async_);
 }
 
+void ForegroundTaskRunner::PostTask(unique_ptr<v8::Task> task) {
+  Post(std::make_unique<PlatformTask>(move(task)));
+}
+
 void ForegroundTaskRunner::PostDelayedTask(unique_ptr<v8::Task> task,
                                            double delay) {
   uint64_t deadline = now_in_ms() + std::llround(delay * 1000);
-  {
-    std::scoped_lock guard(queue_mutex_);
-    delayed_tasks_.push(
-        std::make_unique<PlatformDelayedTask>(move(task), deadline));
-  }
-  uv_async_send(&async_);
+  Post(std::make_unique<PlatformTask>(move(task), deadline));
+}
+
+void ForegroundTaskRunner::PostIdleTask(unique_ptr<v8::IdleTask> task) {
+  CHECK(idle_tasks_enabled_);
+  idle_tasks_.Push(new PlatformIdleTask(move(task)));
 }
 
 void ForegroundTaskRunner::PostNonNestableTask(unique_ptr<v8::Task> task) {
@@ -201,7 +291,9 @@ void ForegroundTaskRunner::PostNonNestableDelayedTask(unique_ptr<v8::Task> task,
   PostDelayedTask(move(task), delay);
 }
 
-AworkerPlatform::AworkerPlatform(ThreadMode thread_mode, int thread_pool_size)
+AworkerPlatform::AworkerPlatform(ThreadMode thread_mode,
+                                 int thread_pool_size,
+                                 bool thread_affinity)
     : thread_mode_(thread_mode) {
   CHECK_EQ(uv_loop_init(&loop_), 0);
   CHECK_EQ(uv_loop_configure(&loop_, UV_METRICS_IDLE_TIME), 0);
@@ -212,13 +304,16 @@ AworkerPlatform::AworkerPlatform(ThreadMode thread_mode, int thread_pool_size)
       std::make_unique<AworkerTraceStateObserver>(controller);
   controller->AddTraceStateObserver(trace_state_observer_.get());
 
-  array_buffer_allocator_ = std::shared_ptr<v8::ArrayBuffer::Allocator>(
-      v8::ArrayBuffer::Allocator::NewDefaultAllocator());
+  array_buffer_allocator_ = std::make_shared<ArrayBufferAllocator>();
 
   if (thread_mode == kMultiThread) {
-    // TODO(chengzhong.wcz): Proper worker thread task runner support.
-    worker_thread_platform_ =
-        v8::platform::NewDefaultPlatform(thread_pool_size);
+    if (thread_pool_size <= 0) {
+      // Leave one CPU to the main thread.
+      thread_pool_size =
+          std::max(1, std::min(GetAvailableParallelism() - 1, 8));
+    }
+    worker_thread_pool_ =
+        std::make_unique<WorkerThreadPool>(thread_pool_size, thread_affinity);
   }
 }
 
@@ -236,8 +331,8 @@ AworkerPlatform::~AworkerPlatform() {
 }
 
 int AworkerPlatform::NumberOfWorkerThreads() {
-  if (thread_mode_) {
-    return worker_thread_platform_->NumberOfWorkerThreads();
+  if (thread_mode_ == kMultiThread) {
+    return worker_thread_pool_->thread_count();
   }
   return 0;
 }
@@ -249,8 +344,8 @@ void AworkerPlatform::CallOnWorkerThread(unique_ptr<v8::Task> task) {
     task_runner_->PostNonNestableTask(std::move(task));
     return;
   }
-  CHECK_NOT_NULL(worker_thread_platform_);
-  worker_thread_platform_->CallOnWorkerThread(std::move(task));
+  CHECK_NOT_NULL(worker_thread_pool_);
+  worker_thread_pool_->PostTask(std::move(task));
 }
 
 void AworkerPlatform::CallDelayedOnWorkerThread(unique_ptr<v8::Task> task,
@@ -263,8 +358,8 @@ void AworkerPlatform::CallDelayedOnWorkerThread(unique_ptr<v8::Task> task,
     task_runner_->PostNonNestableDelayedTask(std::move(task), delay);
     return;
   }
-  CHECK_NOT_NULL(worker_thread_platform_);
-  worker_thread_platform_->CallDelayedOnWorkerThread(std::move(task), delay);
+  CHECK_NOT_NULL(worker_thread_pool_);
+  worker_thread_pool_->PostDelayedTask(std::move(task), delay);
 }
 
 std::unique_ptr<JobHandle> AworkerPlatform::PostJob(
@@ -274,29 +369,7 @@ std::unique_ptr<JobHandle> AworkerPlatform::PostJob(
 }
 
 double AworkerPlatform::MonotonicallyIncreasingTime() {
-#ifdef __APPLE__
-  static bool inited = false;
-  static uint64_t (*time_func)(void);
-  static mach_timebase_info_data_t timebase;
-
-  if (!inited) {
-    CHECK_EQ(mach_timebase_info(&timebase), KERN_SUCCESS);
-    time_func = (uint64_t(*)(void))dlsym(RTLD_DEFAULT, "mach_continuous_time");
-    if (time_func == nullptr) time_func = mach_absolute_time;
-    inited = true;
-  }
-
-  return (time_func() * timebase.numer / timebase.denom) / 1e9;  // NOLINT
-#else
-  struct timespec t;
-  clock_t clock_id;
-
-  clock_id = CLOCK_MONOTONIC;
-
-  if (clock_gettime(clock_id, &t)) return 0; /* Not really possible. */
-
-  return (t.tv_sec * (uint64_t)1e9 + t.tv_nsec) / 1e9;
-#endif
+  return MonotonicTimeInSeconds();
 }
 
 double AworkerPlatform::CurrentClockTimeMillis() {
@@ -311,6 +384,7 @@ void AworkerPlatform::EvaluateCommandlineOptions(CommandlineParserGroup* cli) {
   std::string trace_event_directory =
       cli->has_trace_event_directory() ? cli->trace_event_directory() : cwd();
   trace_agent_->SetLogDirectory(trace_event_directory);
+  task_runner_->set_idle_tasks_enabled(cli->v8_idle_tasks());
   if (cli->enable_trace_event() && cli->has_trace_event_categories()) {
     trace_agent_->Enable(cli->trace_event_categories());
   }
@@ -8,55 +8,74 @@
  *   * PostNonNestableTask -> `PostTask`
  *   * PostNonNestableDelayedTask -> `PostDelayedTask`
  *   * PostTask:
- *     1. Push the task to `task_runner._tasks`;
- *     2. Create the timer with `ForegroundTaskRunner::ImmediateProcessor` if
- *        `task_runner._immediate_task_timer` is not set and then set it;
- *     3. At `ForegroundTaskRunner::ImmediateProcessor`, swap
- * `task_runner._tasks`. Then go through the old list to run previously posted
- * tasks.
+ *     1. Push the task to the lock-free `task_runner.tasks_` queue, which can
+ *        be done from any thread;
+ *     2. Wake up the loop with `task_runner.async_`;
+ *     3. At `ForegroundTaskRunner::ImmediateProcessor`, pop the tasks posted
+ * so far, then go through them to run previously posted tasks.
  *   * PostDelayedTask:
- *     1. Push this task to `task_runner._delayed_tasks` priority queue;
- *     2. Create the timer with `ForegroundTaskRunner::ImmediateProcessor` if
- *        `task_runner._immediate_task_timer` is not set and then set it;
- *     3. At `ForegroundTaskRunner::ImmediateProcessor`, drain deadline met
- * delayed tasks queue items.
+ *     1. Push the task with its deadline to `task_runner.tasks_` too;
+ *     2. Wake up the loop with `task_runner.async_`;
+ *     3. At `ForegroundTaskRunner::ImmediateProcessor`, move the popped
+ * delayed tasks to the `task_runner.delayed_tasks_` priority queue, which is
+ * only accessed on the loop thread, and drain deadline met delayed tasks queue
+ * items. `task_runner.timer_` is scheduled to the next deadline.
+ *   * PostIdleTask:
+ *     1. Push the task to the lock-free `task_runner.idle_tasks_` queue;
+ *     2. At `ForegroundTaskRunner::IdleProcessor`, right before the loop polls
+ * for IO, run the idle tasks until the idle deadline. The deadline is derived
+ * from the poll timeout of the loop, i.e. the next timer, and is capped so
+ * that the loop is never blocked for too long.
  */
 
-#include <list>
-#include <mutex>  // NOLINT(build/c++11)
+#include <atomic>
+#include <deque>
 #include <queue>
+#include <vector>
 
+#include "array_buffer_allocator.h"
 #include "command_parser.h"
 #include "libplatform/libplatform.h"
 #include "tracing/trace_agent.h"
+#include "utils/mpsc_queue.h"
 #include "uv.h"
 #include "v8.h"
+#include "worker_thread_pool.h"
 
 namespace aworker {
 
-class PlatformTask {
+class PlatformTask : public MpscQueueNode {
  public:
-  explicit PlatformTask(std::unique_ptr<v8::Task> task) : task_(move(task)) {}
+  static constexpr uint64_t kNoDeadline = 0;
+
+  explicit PlatformTask(std::unique_ptr<v8::Task> task,
+                        uint64_t deadline = kNoDeadline)
+      : task_(move(task)), deadline_(deadline) {}
 
   inline void Run() { task_->Run(); }
+  inline uint64_t deadline() { return deadline_; }
 
  private:
   std::unique_ptr<v8::Task> task_;
+  uint64_t deadline_;
 };
 
-class PlatformDelayedTask : public PlatformTask {
+class PlatformIdleTask : public MpscQueueNode {
  public:
-  PlatformDelayedTask(std::unique_ptr<v8::Task> task, uint64_t deadline)
-      : PlatformTask(move(task)), deadline_(deadline) {}
-  inline uint64_t deadline() { return deadline_; }
+  explicit PlatformIdleTask(std::unique_ptr<v8::IdleTask> task)
+      : task_(move(task)) {}
+
+  inline void Run(double deadline_in_seconds) {
+    task_->Run(deadline_in_seconds);
+  }
 
  private:
-  uint64_t deadline_;
+  std::unique_ptr<v8::IdleTask> task_;
 };
 
 struct PlatformDelayedTaskCompare {
-  bool operator()(const std::unique_ptr<PlatformDelayedTask>& lhs,
-                  const std::unique_ptr<PlatformDelayedTask>& rhs) const {
+  bool operator()(const std::unique_ptr<PlatformTask>& lhs,
+                  const std::unique_ptr<PlatformTask>& rhs) const {
     return lhs->deadline() > rhs->deadline();
   }
 };
@@ -70,18 +89,19 @@ class ForegroundTaskRunner final : public v8::TaskRunner {
   void PostDelayedTask(std::unique_ptr<v8::Task> task, double delay) override;
   void PostNonNestableDelayedTask(std::unique_ptr<v8::Task> task,
                                   double delay) override;
-  inline void PostIdleTask(std::unique_ptr<v8::IdleTask> task) override {
-    UNREACHABLE();
-  };
+  void PostIdleTask(std::unique_ptr<v8::IdleTask> task) override;
 
-  inline bool IdleTasksEnabled() override { return false; };
+  inline bool IdleTasksEnabled() override { return idle_tasks_enabled_; };
+  inline void set_idle_tasks_enabled(bool enabled) {
+    idle_tasks_enabled_ = enabled;
+  }
   inline bool NonNestableTasksEnabled() const override { return true; }
   inline bool NonNestableDelayedTasksEnabled() const override { return true; }
 
   void DrainTasks();
 
  private:
-  using DelayedTasksPtr = std::unique_ptr<PlatformDelayedTask>;
+  using DelayedTasksPtr = std::unique_ptr<PlatformTask>;
   using DelayedTaskQueue = std::priority_queue<DelayedTasksPtr,
                                                std::vector<DelayedTasksPtr>,
                                                PlatformDelayedTaskCompare>;
@@ -89,18 +109,28 @@ class ForegroundTaskRunner final : public v8::TaskRunner {
   static void Delete(ForegroundTaskRunner* it);
   static void TimerProcessor(uv_timer_t* timer);
   static void ImmediateProcessor(uv_async_t* async);
+  static void IdleProcessor(uv_prepare_t* prepare);
 
   explicit ForegroundTaskRunner(uv_loop_t* loop);
   ~ForegroundTaskRunner() override;
 
   void RunTasks();
+  void RunIdleTasks();
+  void Post(std::unique_ptr<PlatformTask> task);
 
   uv_timer_t timer_;
   uv_async_t async_;
+  uv_prepare_t prepare_;
 
-  std::mutex queue_mutex_;
+  MpscQueue<PlatformTask> tasks_;
+  // Only accessed on the loop thread.
   DelayedTaskQueue delayed_tasks_;
-  std::list<std::unique_ptr<PlatformTask>> tasks_;
+
+  std::atomic<bool> idle_tasks_enabled_{false};
+  MpscQueue<PlatformIdleTask> idle_tasks_;
+  // Idle tasks that didn't fit in the previous idle periods, only accessed on
+  // the loop thread.
+  std::deque<std::unique_ptr<PlatformIdleTask>> pending_idle_tasks_;
 };
 
 class AworkerPlatform : public v8::Platform {
@@ -110,7 +140,9 @@ class AworkerPlatform : public v8::Platform {
     kMultiThread,
   };
 
-  explicit AworkerPlatform(ThreadMode thread_mode, int thread_pool_size = 0);
+  explicit AworkerPlatform(ThreadMode thread_mode,
+                           int thread_pool_size = 0,
+                           bool thread_affinity = false);
   AworkerPlatform(const AworkerPlatform&) = delete;
   ~AworkerPlatform() noexcept override;
 
@@ -140,7 +172,9 @@ class AworkerPlatform : public v8::Platform {
       v8::Isolate* isolate) override {
     return task_runner_;
   }
-  inline bool IdleTasksEnabled(v8::Isolate* isolate) override { return false; }
+  inline bool IdleTasksEnabled(v8::Isolate* isolate) override {
+    return task_runner_->IdleTasksEnabled();
+  }
 
   void EvaluateCommandlineOptions(CommandlineParserGroup* cli);
 
@@ -161,7 +195,7 @@ class AworkerPlatform : public v8::Platform {
   std::unique_ptr<v8::TracingController::TraceStateObserver>
       trace_state_observer_;
   std::shared_ptr<ForegroundTaskRunner> task_runner_;
-  std::unique_ptr<v8::Platform> worker_thread_platform_;
+  std::unique_ptr<WorkerThreadPool> worker_thread_pool_;
   std::shared_ptr<v8::ArrayBuffer::Allocator> array_buffer_allocator_;
 };
 
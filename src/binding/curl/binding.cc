@@ -1,6 +1,8 @@
 #include "binding/curl/curl_def.h"
+#include "binding/curl/curl_dns_cache.h"
 #include "binding/curl/curl_easy.h"
 #include "binding/curl/curl_multi.h"
+#include "binding/curl/curl_share.h"
 #include "binding/curl/curl_version.h"
 #include "immortal.h"
 
@@ -16,7 +18,7 @@ using v8::String;
 using v8::Uint32;
 
 AWORKER_METHOD(CurlInit) {
-  CHECK_EQ(curl_global_init(CURL_GLOBAL_ALL), 0);
+  CurlShare::Initialize();
 }
 
 AWORKER_METHOD(EasyStrErr) {
@@ -30,14 +32,49 @@ AWORKER_METHOD(EasyStrErr) {
   info.GetReturnValue().Set(str);
 }
 
+AWORKER_METHOD(DnsLookup) {
+  Immortal* immortal = Immortal::GetCurrent(info);
+  Isolate* isolate = immortal->isolate();
+  HandleScope scope(isolate);
+
+  Utf8Value host(isolate, info[0]);
+  int port = info[1].As<v8::Int32>()->Value();
+  uint64_t ttl_ms = info[2].As<v8::Uint32>()->Value();
+  std::string addresses =
+      DnsCache::Lookup(immortal->event_loop(), *host, port, ttl_ms);
+  if (addresses.empty()) {
+    return;
+  }
+  info.GetReturnValue().Set(OneByteString(isolate, addresses.c_str()));
+}
+
+AWORKER_METHOD(DnsCacheSize) {
+  info.GetReturnValue().Set(static_cast<uint32_t>(DnsCache::size()));
+}
+
+AWORKER_METHOD(DnsPrewarm) {
+  Immortal* immortal = Immortal::GetCurrent(info);
+  Isolate* isolate = immortal->isolate();
+  HandleScope scope(isolate);
+
+  Utf8Value host(isolate, info[0]);
+  int port = info[1].As<v8::Int32>()->Value();
+  uint64_t ttl_ms = info[2].As<v8::Uint32>()->Value();
+  info.GetReturnValue().Set(DnsCache::ResolveSync(*host, port, ttl_ms));
+}
+
 AWORKER_BINDING(Init) {
   Isolate* isolate = immortal->isolate();
   CurlVersions::Initialize(exports, context, immortal);
   CurlMulti::Initialize(exports, context, immortal);
   CurlEasy::Initialize(exports, context, immortal);
+  DnsResolveReq::Initialize(exports, context, immortal);
 
   immortal->SetFunctionProperty(exports, "init", CurlInit);
   immortal->SetFunctionProperty(exports, "easyStrErr", EasyStrErr);
+  immortal->SetFunctionProperty(exports, "dnsLookup", DnsLookup);
+  immortal->SetFunctionProperty(exports, "dnsPrewarm", DnsPrewarm);
+  immortal->SetFunctionProperty(exports, "dnsCacheSize", DnsCacheSize);
 
   Local<Object> curlopt = Object::New(isolate);
 #define V(VAR)                                                                 \
@@ -48,6 +85,13 @@ AWORKER_BINDING(Init) {
 #undef V
   immortal->SetValueProperty(exports, "Options", curlopt);
 
+  Local<Object> curlmopt = Object::New(isolate);
+#define V(VAR)                                                                 \
+  immortal->SetValueProperty(curlmopt, #VAR, Uint32::New(isolate, VAR));
+  CURL_MULTI_OPTS_INTEGER(V)
+#undef V
+  immortal->SetValueProperty(exports, "MultiOptions", curlmopt);
+
   Local<Object> curl_code = Object::New(isolate);
 #define V(VAR)                                                                 \
   immortal->SetValueProperty(curl_code, #VAR, Uint32::New(isolate, VAR));
@@ -62,6 +106,14 @@ AWORKER_BINDING(Init) {
 #undef V
   immortal->SetValueProperty(exports, "IpResolveOptions", curl_ipresolve);
 
+  Local<Object> curl_http_version = Object::New(isolate);
+#define V(VAR)                                                                 \
+  immortal->SetValueProperty(                                                  \
+      curl_http_version, #VAR, Uint32::New(isolate, VAR));
+  CURL_HTTP_VERSION_OPTS(V)
+#undef V
+  immortal->SetValueProperty(exports, "HttpVersionOptions", curl_http_version);
+
   Local<Object> curl_ssl = Object::New(isolate);
 #define V(VAR)                                                                 \
   immortal->SetValueProperty(curl_ssl, #VAR, Uint32::New(isolate, VAR));
@@ -72,6 +124,7 @@ AWORKER_BINDING(Init) {
 #define V(VAR)                                                                 \
   immortal->SetValueProperty(exports, #VAR, Uint32::New(isolate, VAR));
   CURL_PAUSE_OPTS(V)
+  CURL_PIPE_OPTS(V)
   CURL_READFUNC_FLAGS(V)
 #undef V
 }
@@ -79,9 +132,13 @@ AWORKER_BINDING(Init) {
 AWORKER_EXTERNAL_REFERENCE(Init) {
   registry->Register(CurlInit);
   registry->Register(EasyStrErr);
+  registry->Register(DnsLookup);
+  registry->Register(DnsPrewarm);
+  registry->Register(DnsCacheSize);
   CurlVersions::Initialize(registry);
   CurlMulti::Initialize(registry);
   CurlEasy::Initialize(registry);
+  DnsResolveReq::Initialize(registry);
 }
 
 }  // namespace curl
@@ -9,12 +9,15 @@
       ],
       'sources': [
         'binding.cc',
+        'curl_dns_cache.cc',
         'curl_easy.cc',
         'curl_multi.cc',
+        'curl_share.cc',
         'curl_version.cc',
       ],
       'dependencies': [
         '<(noslate_build_dir)/gypfiles/curl.gyp:libcurl',
+        '<(noslate_openssl_gyp):openssl',
       ],
     },
   ]
@@ -119,6 +119,7 @@
   V(CURLOPT_FRESH_CONNECT)                                                     \
   V(CURLOPT_HTTPAUTH)                                                          \
   V(CURLOPT_HTTPGET)                                                           \
+  V(CURLOPT_HTTP_VERSION)                                                      \
   V(CURLOPT_HTTP_CONTENT_DECODING)                                             \
   V(CURLOPT_HTTP_TRANSFER_DECODING)                                            \
   V(CURLOPT_IGNORE_CONTENT_LENGTH)                                             \
@@ -130,6 +131,7 @@
   V(CURLOPT_NOPROGRESS)                                                        \
   V(CURLOPT_NOSIGNAL)                                                          \
   V(CURLOPT_PATH_AS_IS)                                                        \
+  V(CURLOPT_PIPEWAIT)                                                          \
   V(CURLOPT_POST)                                                              \
   V(CURLOPT_POSTFIELDSIZE)                                                     \
   V(CURLOPT_POSTREDIR)                                                         \
@@ -194,6 +196,23 @@
   V(CURLOPT_HTTPPOST)                                                          \
   V(CURLOPT_RESOLVE)
 
+/**
+ * See https://curl.se/libcurl/c/curl_multi_setopt.html
+ */
+#define CURL_MULTI_OPTS_INTEGER(V)                                             \
+  V(CURLMOPT_MAXCONNECTS)                                                      \
+  V(CURLMOPT_MAX_CONCURRENT_STREAMS)                                           \
+  V(CURLMOPT_MAX_HOST_CONNECTIONS)                                             \
+  V(CURLMOPT_MAX_TOTAL_CONNECTIONS)                                            \
+  V(CURLMOPT_PIPELINING)
+
+/**
+ * See https://curl.se/libcurl/c/CURLMOPT_PIPELINING.html
+ */
+#define CURL_PIPE_OPTS(V)                                                      \
+  V(CURLPIPE_NOTHING)                                                          \
+  V(CURLPIPE_MULTIPLEX)
+
 /**
  * See https://curl.se/libcurl/c/CURLOPT_IPRESOLVE.html
  */
@@ -202,6 +221,15 @@
   V(CURL_IPRESOLVE_V4)                                                         \
   V(CURL_IPRESOLVE_V6)
 
+/**
+ * See https://curl.se/libcurl/c/CURLOPT_HTTP_VERSION.html
+ */
+#define CURL_HTTP_VERSION_OPTS(V)                                              \
+  V(CURL_HTTP_VERSION_NONE)                                                    \
+  V(CURL_HTTP_VERSION_1_1)                                                     \
+  V(CURL_HTTP_VERSION_2TLS)                                                    \
+  V(CURL_HTTP_VERSION_2_PRIOR_KNOWLEDGE)
+
 /**
  * See https://curl.se/libcurl/c/CURLOPT_SSL_OPTIONS.html
  */
@@ -0,0 +1,309 @@
+#include "binding/curl/curl_dns_cache.h"
+#include <netdb.h>
+#include <cstring>
+#include <set>
+
+#include "debug_utils-inl.h"
+#include "immortal.h"
+#include "util.h"
+
+namespace aworker {
+namespace curl {
+
+using per_process::Debug;
+using v8::FunctionTemplate;
+using v8::HandleScope;
+using v8::Isolate;
+using v8::Local;
+using v8::Object;
+using v8::String;
+using v8::Undefined;
+using v8::Value;
+
+#define NS_PER_MS (1000 * 1000)
+// Refresh the entry in the background once 80% of its ttl elapsed.
+#define DNS_REFRESH_PERCENT 80
+
+std::unordered_map<std::string, DnsCache::Entry> DnsCache::entries_;
+std::list<std::string> DnsCache::lru_;
+
+// static
+std::string DnsCache::KeyOf(const std::string& host, int port) {
+  return host + ":" + std::to_string(port);
+}
+
+// static
+DnsCache::Entry* DnsCache::Touch(const std::string& key) {
+  auto it = entries_.find(key);
+  if (it != entries_.end()) {
+    lru_.splice(lru_.begin(), lru_, it->second.lru_position);
+    return &it->second;
+  }
+  lru_.push_front(key);
+  Entry* entry = &entries_[key];
+  entry->lru_position = lru_.begin();
+  Evict();
+  return entry;
+}
+
+// static
+void DnsCache::Evict() {
+  auto it = lru_.end();
+  while (entries_.size() > kMaxEntries && it != lru_.begin()) {
+    --it;
+    auto entry_it = entries_.find(*it);
+    // Entries being resolved are retained until their resolutions complete,
+    // and the most recently used one is the entry being inserted.
+    if (entry_it->second.resolving || it == lru_.begin()) {
+      continue;
+    }
+    Debug(DebugCategory::CURL, "evict %s\n", *it);
+    entries_.erase(entry_it);
+    it = lru_.erase(it);
+  }
+}
+
+// static
+bool DnsCache::StartResolve(uv_loop_t* loop,
+                            const std::string& host,
+                            int port,
+                            uint64_t ttl_ms,
+                            Entry* entry) {
+  ResolveReq* req = new ResolveReq();
+  req->key = KeyOf(host, port);
+  req->ttl_ms = ttl_ms;
+  struct addrinfo hints;
+  memset(&hints, 0, sizeof(hints));
+  hints.ai_family = AF_UNSPEC;
+  hints.ai_socktype = SOCK_STREAM;
+  int err = uv_getaddrinfo(loop,
+                           &req->req,
+                           OnResolved,
+                           host.c_str(),
+                           std::to_string(port).c_str(),
+                           &hints);
+  if (err != 0) {
+    delete req;
+    return false;
+  }
+  entry->resolving = true;
+  return true;
+}
+
+// static
+std::string DnsCache::Lookup(uv_loop_t* loop,
+                             const std::string& host,
+                             int port,
+                             uint64_t ttl_ms) {
+  std::string key = KeyOf(host, port);
+  if (entries_.find(key) == entries_.end()) {
+    // Cold host names are resolved with `Resolve`, so that they are not
+    // resolved by both the cache and curl.
+    return "";
+  }
+  Entry* entry = Touch(key);
+  uint64_t now = uv_hrtime();
+  if (!entry->resolving && now >= entry->refresh_time) {
+    StartResolve(loop, host, port, ttl_ms, entry);
+  }
+  if (now >= entry->expiry_time) {
+    return "";
+  }
+  return entry->addresses;
+}
+
+// static
+bool DnsCache::Resolve(uv_loop_t* loop,
+                       const std::string& host,
+                       int port,
+                       uint64_t ttl_ms,
+                       ResolveCallback callback) {
+  Entry* entry = Touch(KeyOf(host, port));
+  if (!entry->resolving && !StartResolve(loop, host, port, ttl_ms, entry)) {
+    return false;
+  }
+  entry->callbacks.push_back(std::move(callback));
+  return true;
+}
+
+// static
+bool DnsCache::ResolveSync(const std::string& host,
+                           int port,
+                           uint64_t ttl_ms) {
+  struct addrinfo hints;
+  memset(&hints, 0, sizeof(hints));
+  hints.ai_family = AF_UNSPEC;
+  hints.ai_socktype = SOCK_STREAM;
+  struct addrinfo* res = nullptr;
+  int err = getaddrinfo(
+      host.c_str(), std::to_string(port).c_str(), &hints, &res);
+  if (err != 0) {
+    Debug(DebugCategory::CURL,
+          "failed to resolve %s: %s\n",
+          host,
+          gai_strerror(err));
+    return false;
+  }
+  Store(Touch(KeyOf(host, port)), res, ttl_ms);
+  freeaddrinfo(res);
+  return true;
+}
+
+// static
+void DnsCache::Store(Entry* entry,
+                     const struct addrinfo* res,
+                     uint64_t ttl_ms) {
+  std::set<std::string> seen;
+  std::string addresses;
+  char ip[INET6_ADDRSTRLEN];
+  for (const struct addrinfo* it = res; it != nullptr; it = it->ai_next) {
+    std::string address;
+    if (it->ai_family == AF_INET) {
+      uv_ip4_name(reinterpret_cast<const struct sockaddr_in*>(it->ai_addr),
+                  ip,
+                  sizeof(ip));
+      address = ip;
+    } else if (it->ai_family == AF_INET6) {
+      uv_ip6_name(reinterpret_cast<const struct sockaddr_in6*>(it->ai_addr),
+                  ip,
+                  sizeof(ip));
+      address = std::string("[") + ip + "]";
+    } else {
+      continue;
+    }
+    if (!seen.insert(address).second) {
+      continue;
+    }
+    if (!addresses.empty()) {
+      addresses += ",";
+    }
+    addresses += address;
+  }
+  if (addresses.empty()) {
+    return;
+  }
+
+  uint64_t now = uv_hrtime();
+  entry->addresses = std::move(addresses);
+  entry->refresh_time = now + ttl_ms * NS_PER_MS * DNS_REFRESH_PERCENT / 100;
+  entry->expiry_time = now + ttl_ms * NS_PER_MS;
+}
+
+// static
+void DnsCache::OnResolved(uv_getaddrinfo_t* req,
+                          int status,
+                          struct addrinfo* res) {
+  ResolveReq* resolve_req = ContainerOf(&ResolveReq::req, req);
+  auto it = entries_.find(resolve_req->key);
+  // Entries being resolved are not evicted.
+  CHECK(it != entries_.end());
+  Entry& entry = it->second;
+  entry.resolving = false;
+  std::string addresses;
+  if (status == 0) {
+    Store(&entry, res, resolve_req->ttl_ms);
+    addresses = entry.addresses;
+    Debug(DebugCategory::CURL,
+          "resolved %s: %s\n",
+          resolve_req->key,
+          addresses);
+  } else {
+    // Retried on the next lookup.
+    Debug(DebugCategory::CURL,
+          "failed to resolve %s: %s\n",
+          resolve_req->key,
+          uv_strerror(status));
+  }
+  // The callbacks may look up the cache again.
+  std::vector<ResolveCallback> callbacks = std::move(entry.callbacks);
+  entry.callbacks.clear();
+  uv_freeaddrinfo(res);
+  delete resolve_req;
+  Evict();
+
+  for (const ResolveCallback& callback : callbacks) {
+    callback(addresses);
+  }
+}
+
+const WrapperTypeInfo DnsResolveReq::wrapper_type_info_{
+    "curl_dns_resolve_req",
+};
+
+AWORKER_BINDING(DnsResolveReq::Initialize) {
+  Isolate* isolate = immortal->isolate();
+  Local<FunctionTemplate> tpl =
+      FunctionTemplate::New(isolate, DnsResolveReq::New);
+  tpl->Inherit(AsyncWrap::GetConstructorTemplate(immortal));
+  tpl->InstanceTemplate()->SetInternalFieldCount(
+      BaseObject::kInternalFieldCount);
+
+  Local<String> name = OneByteString(isolate, "DnsResolveReq");
+  tpl->SetClassName(name);
+  immortal->SetFunctionProperty(
+      tpl->PrototypeTemplate(), "resolve", DnsResolveReq::Resolve);
+
+  exports->Set(context, name, tpl->GetFunction(context).ToLocalChecked())
+      .Check();
+  immortal->SetIntegerProperty(exports,
+                               "DNS_CACHE_MAX_ENTRIES",
+                               static_cast<int>(DnsCache::kMaxEntries));
+}
+
+AWORKER_EXTERNAL_REFERENCE(DnsResolveReq::Initialize) {
+  registry->Register(New);
+  registry->Register(Resolve);
+}
+
+AWORKER_METHOD(DnsResolveReq::New) {
+  Immortal* immortal = Immortal::GetCurrent(info);
+  HandleScope scope(immortal->isolate());
+
+  new DnsResolveReq(immortal, info.This());
+
+  info.GetReturnValue().Set(info.This());
+}
+
+AWORKER_METHOD(DnsResolveReq::Resolve) {
+  Immortal* immortal = Immortal::GetCurrent(info);
+  Isolate* isolate = immortal->isolate();
+  HandleScope scope(isolate);
+
+  DnsResolveReq* req;
+  ASSIGN_OR_RETURN_UNWRAP(&req, info.This());
+
+  Utf8Value host(isolate, info[0]);
+  int port = info[1].As<v8::Int32>()->Value();
+  uint64_t ttl_ms = info[2].As<v8::Uint32>()->Value();
+  bool started = DnsCache::Resolve(
+      immortal->event_loop(),
+      *host,
+      port,
+      ttl_ms,
+      [req](const std::string& addresses) { req->OnComplete(addresses); });
+  if (!started) {
+    // OnComplete is never called, release the request here.
+    req->MakeWeak();
+  }
+  info.GetReturnValue().Set(started);
+}
+
+DnsResolveReq::DnsResolveReq(Immortal* immortal, Local<Object> object)
+    : AsyncWrap(immortal, object) {}
+
+void DnsResolveReq::OnComplete(const std::string& addresses) {
+  HandleScope scope(immortal()->isolate());
+  Local<Value> argv[] = {
+      addresses.empty() ? Undefined(immortal()->isolate()).As<Value>()
+                        : OneByteString(immortal()->isolate(),
+                                        addresses.c_str())
+                              .As<Value>(),
+  };
+  MakeCallback(OneByteString(immortal()->isolate(), "_onComplete"),
+               arraysize(argv),
+               argv);
+  MakeWeak();
+}
+
+}  // namespace curl
+}  // namespace aworker
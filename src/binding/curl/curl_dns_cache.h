@@ -0,0 +1,134 @@
+#ifndef SRC_BINDING_CURL_CURL_DNS_CACHE_H_
+#define SRC_BINDING_CURL_CURL_DNS_CACHE_H_
+
+#include <functional>
+#include <list>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "async_wrap.h"
+#include "uv.h"
+
+namespace aworker {
+namespace curl {
+
+/**
+ * Process-wide cache of resolved host names, fed to curl easy handles with
+ * CURLOPT_RESOLVE.
+ *
+ * Unlike the DNS cache of libcurl, the entries are refreshed on the libuv
+ * thread pool before they expire, and can be resolved in the seed process
+ * before warm fork so that the first requests of forked workers don't wait
+ * for the resolver.
+ *
+ * At most kMaxEntries host names are cached, the least recently used ones
+ * are evicted first.
+ */
+class DnsCache {
+ public:
+  static constexpr size_t kMaxEntries = 256;
+
+  using ResolveCallback = std::function<void(const std::string& addresses)>;
+
+  /**
+   * Returns the comma separated addresses of the host in the format of
+   * CURLOPT_RESOLVE, or an empty string if there is no fresh entry. Expiring
+   * entries are refreshed in the background. Host names that have not been
+   * resolved yet are not resolved by `Lookup`, use `Resolve` instead.
+   */
+  static std::string Lookup(uv_loop_t* loop,
+                            const std::string& host,
+                            int port,
+                            uint64_t ttl_ms);
+
+  /**
+   * Resolve the host on the libuv thread pool, or join the pending
+   * resolution of the host, and return if the resolution is started. The
+   * callback is invoked with the addresses, or an empty string if the host
+   * can not be resolved.
+   */
+  static bool Resolve(uv_loop_t* loop,
+                      const std::string& host,
+                      int port,
+                      uint64_t ttl_ms,
+                      ResolveCallback callback);
+
+  /**
+   * Resolve the host synchronously, and return if it is resolved. Only meant
+   * to be used when preparing the process, e.g. before warm fork.
+   */
+  static bool ResolveSync(const std::string& host, int port, uint64_t ttl_ms);
+
+  static inline size_t size() { return entries_.size(); }
+
+ private:
+  struct Entry {
+    std::string addresses;
+    uint64_t refresh_time = 0;
+    uint64_t expiry_time = 0;
+    bool resolving = false;
+    std::vector<ResolveCallback> callbacks;
+    std::list<std::string>::iterator lru_position;
+  };
+
+  struct ResolveReq {
+    uv_getaddrinfo_t req;
+    std::string key;
+    uint64_t ttl_ms;
+  };
+
+  DnsCache();
+  ~DnsCache();
+
+  DnsCache(const DnsCache& that);
+  DnsCache& operator=(const DnsCache& that);
+
+  static std::string KeyOf(const std::string& host, int port);
+  // Get the entry of the key, creating it if missing, and mark it as the
+  // most recently used one.
+  static Entry* Touch(const std::string& key);
+  static void Evict();
+  static bool StartResolve(uv_loop_t* loop,
+                           const std::string& host,
+                           int port,
+                           uint64_t ttl_ms,
+                           Entry* entry);
+  static void Store(Entry* entry, const struct addrinfo* res, uint64_t ttl_ms);
+  static void OnResolved(uv_getaddrinfo_t* req,
+                         int status,
+                         struct addrinfo* res);
+
+  static std::unordered_map<std::string, Entry> entries_;
+  // Keys of the entries, the most recently used first.
+  static std::list<std::string> lru_;
+};
+
+/**
+ * JavaScript handle of a `DnsCache::Resolve` request, `_onComplete` is
+ * called with the addresses, or undefined if the host can not be resolved.
+ * The handle is kept alive until the request has completed.
+ */
+class DnsResolveReq : public AsyncWrap {
+  DEFINE_WRAPPERTYPEINFO();
+  SIZE_IN_BYTES(DnsResolveReq)
+  SET_NO_MEMORY_INFO()
+
+ public:
+  static AWORKER_BINDING(Initialize);
+  static AWORKER_EXTERNAL_REFERENCE(Initialize);
+
+  static AWORKER_METHOD(New);
+  static AWORKER_METHOD(Resolve);
+
+ private:
+  DnsResolveReq(Immortal* immortal, v8::Local<v8::Object> object);
+  ~DnsResolveReq() = default;
+
+  void OnComplete(const std::string& addresses);
+};
+
+}  // namespace curl
+}  // namespace aworker
+
+#endif  // SRC_BINDING_CURL_CURL_DNS_CACHE_H_
@@ -1,11 +1,19 @@
 #include "binding/curl/curl_easy.h"
+#include <algorithm>
+#include "array_buffer_allocator.h"
+#include "binding/curl/curl_share.h"
 #include "error_handling.h"
+#include "utils/async_primitives.h"
 #include "utils/resizable_buffer.h"
 
+#define WRITE_CHUNK_SIZE (64 * 1024)
+#define MAX_FREE_WRITE_CHUNKS 32
+
 namespace aworker {
 namespace curl {
 using v8::Array;
 using v8::ArrayBuffer;
+using v8::ArrayBufferView;
 using v8::BackingStore;
 using v8::Context;
 using v8::FunctionTemplate;
@@ -19,10 +27,54 @@ using v8::String;
 using v8::Uint32;
 using v8::Value;
 
-static char* root_certs = {
-#include "binding/curl/root_certs.h"  // NOLINT(build/include_order)
+namespace {
+// Response body chunks are handed to JavaScript land as the backing stores
+// of array buffers, and are returned to the pool once the array buffers are
+// collected. The backing store deleters may be called on any thread.
+class WriteChunkPool {
+ public:
+  ~WriteChunkPool() {
+    for (char* it : free_) {
+      delete[] it;
+    }
+  }
+
+  char* Acquire() {
+    {
+      ScopedLock lock(mutex_);
+      if (!free_.empty()) {
+        char* it = free_.back();
+        free_.pop_back();
+        return it;
+      }
+    }
+    return new char[WRITE_CHUNK_SIZE];
+  }
+
+  void Release(char* data) {
+    {
+      ScopedLock lock(mutex_);
+      if (free_.size() < MAX_FREE_WRITE_CHUNKS) {
+        free_.push_back(data);
+        return;
+      }
+    }
+    delete[] data;
+  }
+
+  static void Free(void* data, size_t length, void* deleter_data) {
+    static_cast<WriteChunkPool*>(deleter_data)->Release(
+        static_cast<char*>(data));
+  }
+
+ private:
+  std::mutex mutex_;
+  std::vector<char*> free_;
 };
 
+WriteChunkPool write_chunk_pool;
+}  // namespace
+
 const WrapperTypeInfo CurlEasy::wrapper_type_info_{
     "curl_easy",
 };
@@ -40,6 +92,8 @@ AWORKER_BINDING(CurlEasy::Initialize) {
   Local<ObjectTemplate> prototype_template = tpl->PrototypeTemplate();
   immortal->SetFunctionProperty(prototype_template, "setOpt", SetOpt);
   immortal->SetFunctionProperty(prototype_template, "pause", Pause);
+  immortal->SetFunctionProperty(prototype_template, "writeBody", WriteBody);
+  immortal->SetFunctionProperty(prototype_template, "endBody", EndBody);
 
   exports->Set(context, name, tpl->GetFunction(context).ToLocalChecked())
       .Check();
@@ -49,6 +103,8 @@ AWORKER_EXTERNAL_REFERENCE(CurlEasy::Initialize) {
   registry->Register(New);
   registry->Register(SetOpt);
   registry->Register(Pause);
+  registry->Register(WriteBody);
+  registry->Register(EndBody);
 }
 
 AWORKER_METHOD(CurlEasy::New) {
@@ -110,6 +166,9 @@ AWORKER_METHOD(CurlEasy::SetOpt) {
     if (opt == CURLOPT_HTTPHEADER) {
       if (ce->headers_) curl_slist_free_all(ce->headers_);
       ce->headers_ = slist;
+    } else if (opt == CURLOPT_RESOLVE) {
+      if (ce->resolve_) curl_slist_free_all(ce->resolve_);
+      ce->resolve_ = slist;
     }
     return;
   }
@@ -129,6 +188,44 @@ AWORKER_METHOD(CurlEasy::Pause) {
   info.GetReturnValue().Set(static_cast<int32_t>(code));
 }
 
+AWORKER_METHOD(CurlEasy::WriteBody) {
+  Immortal* immortal = Immortal::GetCurrent(info);
+  Isolate* isolate = immortal->isolate();
+  HandleScope scope(isolate);
+
+  CurlEasy* ce;
+  ASSIGN_OR_RETURN_UNWRAP(&ce, info.This());
+
+  CHECK(info[0]->IsArrayBufferView());
+  Local<ArrayBufferView> view = info[0].As<ArrayBufferView>();
+  if (view->ByteLength() > 0) {
+    ce->read_chunks_.push_back({view->Buffer()->GetBackingStore(),
+                                view->ByteOffset(),
+                                view->ByteLength()});
+  }
+  info.GetReturnValue().Set(ce->TakeReadPaused());
+}
+
+AWORKER_METHOD(CurlEasy::EndBody) {
+  Immortal* immortal = Immortal::GetCurrent(info);
+  Isolate* isolate = immortal->isolate();
+  HandleScope scope(isolate);
+
+  CurlEasy* ce;
+  ASSIGN_OR_RETURN_UNWRAP(&ce, info.This());
+
+  ce->read_ended_ = true;
+  info.GetReturnValue().Set(ce->TakeReadPaused());
+}
+
+// Returns if the transfer was paused for the lack of request body, the caller
+// is responsible for resuming the transfer.
+bool CurlEasy::TakeReadPaused() {
+  bool paused = read_paused_;
+  read_paused_ = false;
+  return paused;
+}
+
 // static
 CurlEasy* CurlEasy::FromEasyHandle(CURL* easy_handle) {
   // From https://curl.haxx.se/libcurl/c/CURLINFO_PRIVATE.html
@@ -153,11 +250,7 @@ CurlEasy::CurlEasy(Immortal* immortal, Local<Object> obj)
   // Refer to https://curl.se/libcurl/c/curl_easy_setopt.html for more info.
   curl_easy_setopt(easy_handle_, CURLOPT_PRIVATE, this);
 
-  struct curl_blob blob;
-  blob.data = root_certs;
-  blob.len = strlen(root_certs);
-  blob.flags = CURL_BLOB_NOCOPY;
-  curl_easy_setopt(easy_handle_, CURLOPT_CAINFO_BLOB, &blob);
+  CurlShare::Attach(easy_handle_);
 
   curl_easy_setopt(easy_handle_, CURLOPT_HEADERDATA, this);
   curl_easy_setopt(easy_handle_, CURLOPT_HEADERFUNCTION, OnHeader);
@@ -173,11 +266,59 @@ CurlEasy::CurlEasy(Immortal* immortal, Local<Object> obj)
 }
 
 CurlEasy::~CurlEasy() {
-  if (headers_) curl_slist_free_all(headers_);
+  for (const WriteChunk& chunk : write_chunks_) {
+    write_chunk_pool.Release(chunk.data);
+  }
   curl_easy_cleanup(easy_handle_);
+  if (headers_) curl_slist_free_all(headers_);
+  if (resolve_) curl_slist_free_all(resolve_);
+}
+
+void CurlEasy::FlushWrites() {
+  if (write_chunks_.empty()) {
+    return;
+  }
+  HandleScope scope(isolate());
+
+  std::vector<Local<Value>> buffers;
+  buffers.reserve(write_chunks_.size());
+  for (const WriteChunk& chunk : write_chunks_) {
+    if (chunk.length < WRITE_CHUNK_SIZE) {
+      // Copy the partially filled chunk out so that the ArrayBuffer doesn't
+      // pin a whole chunk, the chunk is recycled immediately.
+      Local<ArrayBuffer> ab;
+      {
+        ArrayBufferAllocator::NoZeroFillScope no_zero_fill_scope;
+        ab = ArrayBuffer::New(isolate(), chunk.length);
+      }
+      memcpy(ab->GetBackingStore()->Data(), chunk.data, chunk.length);
+      write_chunk_pool.Release(chunk.data);
+      buffers.push_back(ab);
+      continue;
+    }
+    std::shared_ptr<BackingStore> bs = ArrayBuffer::NewBackingStore(
+        chunk.data, chunk.length, WriteChunkPool::Free, &write_chunk_pool);
+    buffers.push_back(ArrayBuffer::New(isolate(), std::move(bs)));
+  }
+  write_chunks_.clear();
+
+  Local<v8::Value> argv[] = {
+      Array::New(isolate(), buffers.data(), buffers.size())};
+  MaybeLocal<Value> ret =
+      MakeCallback(OneByteString(isolate(), "_onWrite"), arraysize(argv), argv);
+  if (ret.IsEmpty()) {
+    // Abort the transfer on the next write.
+    write_failed_ = true;
+  }
 }
 
 void CurlEasy::OnDone(CURLcode code) {
+  FlushWrites();
+  // The body has not been fully delivered, fail the request even if libcurl
+  // completed the transfer.
+  if (write_failed_ && code == CURLE_OK) {
+    code = CURLE_WRITE_ERROR;
+  }
   HandleScope scope(isolate());
   curl_off_t total_time_t;
   curl_off_t namelookup_time_t;
@@ -236,22 +377,28 @@ size_t CurlEasy::OnHeader(char* buffer,
 // static
 size_t CurlEasy::OnWrite(char* ptr, size_t size, size_t nmemb, void* userdata) {
   CurlEasy* ce = static_cast<CurlEasy*>(userdata);
-  Isolate* isolate = ce->isolate();
-  HandleScope scope(isolate);
-
-  std::shared_ptr<BackingStore> bs =
-      ArrayBuffer::NewBackingStore(isolate, nmemb);
-  memcpy(bs->Data(), ptr, nmemb);
-  Local<ArrayBuffer> ab = ArrayBuffer::New(isolate, bs);
-
-  Local<v8::Value> argv[] = {ab};
-  MaybeLocal<Value> ret = ce->MakeCallback(
-      OneByteString(isolate, "_onWrite"), arraysize(argv), argv);
-  if (ret.IsEmpty()) {
+  if (ce->write_failed_) {
     return 0;
   }
 
-  return nmemb;
+  // Accumulate the chunks, they are flushed to JavaScript land once the
+  // multi handle finished processing the current socket event.
+  size_t nbytes = size * nmemb;
+  size_t offset = 0;
+  while (offset < nbytes) {
+    if (ce->write_chunks_.empty() ||
+        ce->write_chunks_.back().length == WRITE_CHUNK_SIZE) {
+      ce->write_chunks_.push_back({write_chunk_pool.Acquire(), 0});
+    }
+    WriteChunk& chunk = ce->write_chunks_.back();
+    size_t count =
+        std::min(nbytes - offset, WRITE_CHUNK_SIZE - chunk.length);
+    memcpy(chunk.data + chunk.length, ptr + offset, count);
+    chunk.length += count;
+    offset += count;
+  }
+
+  return nbytes;
 }
 
 // static
@@ -260,39 +407,33 @@ size_t CurlEasy::OnRead(char* buffer,
                         size_t nitems,
                         void* userdata) {
   CurlEasy* ce = static_cast<CurlEasy*>(userdata);
-  Isolate* isolate = ce->isolate();
-  HandleScope scope(isolate);
 
-  // copy as much data as possible into the 'ptr' buffer, but no more than
-  // 'size' * 'nmemb' bytes.
-  size_t nread = size * nitems;
-  std::shared_ptr<BackingStore> bs = ArrayBuffer::NewBackingStore(
-      buffer,
-      nread,
-      [](void* data, size_t length, void* deleter_data) {},
-      nullptr);
-  Local<ArrayBuffer> ab = ArrayBuffer::New(isolate, bs);
-
-  Local<v8::Value> argv[] = {
-      Uint32::New(isolate, static_cast<uint32_t>(nread)),
-      ab,
-  };
-  MaybeLocal<Value> maybe_ret = ce->MakeCallback(
-      OneByteString(isolate, "_onRead"), arraysize(argv), argv);
-
-  ab->Detach();
-
-  Local<Value> ret;
-  if (!maybe_ret.ToLocal(&ret)) {
-    return CURL_READFUNC_ABORT;
+  // copy as much data as possible into the 'buffer', but no more than
+  // 'size' * 'nitems' bytes.
+  size_t capacity = size * nitems;
+  if (capacity == 0) {
+    return 0;
   }
-
-  uint32_t retcode;
-  if (!ret->Uint32Value(ce->immortal()->context()).To(&retcode)) {
-    return CURL_READFUNC_ABORT;
+  size_t nread = 0;
+  while (nread < capacity && !ce->read_chunks_.empty()) {
+    ReadChunk& chunk = ce->read_chunks_.front();
+    size_t count = std::min(capacity - nread, chunk.length);
+    memcpy(buffer + nread,
+           static_cast<char*>(chunk.store->Data()) + chunk.offset,
+           count);
+    chunk.offset += count;
+    chunk.length -= count;
+    nread += count;
+    if (chunk.length == 0) {
+      ce->read_chunks_.pop_front();
+    }
   }
 
-  return static_cast<size_t>(retcode);
+  if (nread > 0 || ce->read_ended_) {
+    return nread;
+  }
+  ce->read_paused_ = true;
+  return CURL_READFUNC_PAUSE;
 }
 
 // static
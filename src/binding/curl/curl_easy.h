@@ -2,6 +2,9 @@
 #define SRC_BINDING_CURL_CURL_EASY_H_
 
 #include <curl/curl.h>
+#include <deque>
+#include <memory>
+#include <vector>
 
 #include "async_wrap.h"
 
@@ -20,12 +23,20 @@ class CurlEasy : public AsyncWrap {
   static AWORKER_METHOD(New);
   static AWORKER_METHOD(SetOpt);
   static AWORKER_METHOD(Pause);
+  static AWORKER_METHOD(WriteBody);
+  static AWORKER_METHOD(EndBody);
 
   static CurlEasy* FromEasyHandle(CURL* easy_handle);
 
   CURL* easy_handle() { return easy_handle_; }
   void OnDone(CURLcode code);
 
+  /**
+   * Deliver the response body chunks received since the last flush to
+   * JavaScript land with a single callback.
+   */
+  void FlushWrites();
+
  private:
   static size_t OnHeader(char* buffer,
                          size_t size,
@@ -45,8 +56,32 @@ class CurlEasy : public AsyncWrap {
   CurlEasy(Immortal* immortal, v8::Local<v8::Object> object);
   ~CurlEasy();
 
+  struct WriteChunk {
+    char* data;
+    size_t length;
+  };
+
+  struct ReadChunk {
+    std::shared_ptr<v8::BackingStore> store;
+    size_t offset;
+    size_t length;
+  };
+
+  bool TakeReadPaused();
+
   CURL* easy_handle_;
   struct curl_slist* headers_;
+  struct curl_slist* resolve_ = nullptr;
+
+  // Response body chunks pending to be flushed, all but the last one are full.
+  std::vector<WriteChunk> write_chunks_;
+  bool write_failed_ = false;
+
+  // Request body chunks queued by JavaScript land, retained until they are
+  // copied into the buffers of libcurl.
+  std::deque<ReadChunk> read_chunks_;
+  bool read_ended_ = false;
+  bool read_paused_ = false;
 };
 
 }  // namespace curl
@@ -9,16 +9,24 @@ namespace curl {
 using v8::Context;
 using v8::FunctionTemplate;
 using v8::HandleScope;
+using v8::Int32;
 using v8::Isolate;
 using v8::Local;
 using v8::Object;
 using v8::ObjectTemplate;
 using v8::String;
+using v8::Uint32;
 
 const WrapperTypeInfo CurlMulti::wrapper_type_info_{
     "curl_multi",
 };
 
+ConnectionStatistics CurlMulti::connection_statistics_;
+
+const ConnectionStatistics& GetConnectionStatistics() {
+  return CurlMulti::connection_statistics_;
+}
+
 AWORKER_BINDING(CurlMulti::Initialize) {
   Local<FunctionTemplate> tpl =
       FunctionTemplate::New(immortal->isolate(), CurlMulti::New);
@@ -30,6 +38,7 @@ AWORKER_BINDING(CurlMulti::Initialize) {
   tpl->SetClassName(name);
 
   Local<ObjectTemplate> prototype_template = tpl->PrototypeTemplate();
+  immortal->SetFunctionProperty(prototype_template, "setOpt", SetOpt);
   immortal->SetFunctionProperty(prototype_template, "addHandle", AddHandle);
   immortal->SetFunctionProperty(
       prototype_template, "removeHandle", RemoveHandle);
@@ -41,6 +50,7 @@ AWORKER_BINDING(CurlMulti::Initialize) {
 
 AWORKER_EXTERNAL_REFERENCE(CurlMulti::Initialize) {
   registry->Register(New);
+  registry->Register(SetOpt);
   registry->Register(AddHandle);
   registry->Register(RemoveHandle);
   registry->Register(Close);
@@ -56,6 +66,24 @@ AWORKER_METHOD(CurlMulti::New) {
   info.GetReturnValue().Set(info.This());
 }
 
+AWORKER_METHOD(CurlMulti::SetOpt) {
+  Immortal* immortal = Immortal::GetCurrent(info);
+  Isolate* isolate = immortal->isolate();
+  HandleScope scope(isolate);
+
+  CurlMulti* cm;
+  ASSIGN_OR_RETURN_UNWRAP(&cm, info.This());
+
+  CURLMoption opt = static_cast<CURLMoption>(info[0].As<Uint32>()->Value());
+  CHECK(info[1]->IsInt32());
+  CURLMcode code = curl_multi_setopt(
+      cm->multi_handle_, opt, static_cast<long>(info[1].As<Int32>()->Value()));
+  if (code != CURLMcode::CURLM_OK) {
+    ThrowException(isolate, curl_multi_strerror(code));
+    return;
+  }
+}
+
 AWORKER_METHOD(CurlMulti::AddHandle) {
   Immortal* immortal = Immortal::GetCurrent(info);
   Isolate* isolate = immortal->isolate();
@@ -144,6 +172,17 @@ void CurlMulti::OnClose(uv_handle_t* handle) {
 }
 
 void CurlMulti::ProcessMessages() {
+  // Flush the response body chunks received in this round. The callbacks may
+  // remove handles from the multi handle.
+  std::vector<CurlEasy*> handles(pending_handles_.cbegin(),
+                                 pending_handles_.cend());
+  for (CurlEasy* ce : handles) {
+    if (pending_handles_.find(ce) == pending_handles_.cend()) {
+      continue;
+    }
+    ce->FlushWrites();
+  }
+
   CURLMsg* msg = NULL;
   int pending = 0;
 
@@ -151,12 +190,26 @@ void CurlMulti::ProcessMessages() {
     if (msg->msg == CURLMSG_DONE) {
       CURLcode code = msg->data.result;
 
+      RecordConnectionStatistics(msg->easy_handle);
       CurlEasy* ce = CurlEasy::FromEasyHandle(msg->easy_handle);
       ce->OnDone(code);
     }
   }
 }
 
+void CurlMulti::RecordConnectionStatistics(CURL* easy_handle) {
+  long num_connects = 0;  // NOLINT(runtime/int)
+  if (curl_easy_getinfo(easy_handle, CURLINFO_NUM_CONNECTS, &num_connects) !=
+      CURLE_OK) {
+    return;
+  }
+  connection_statistics_.transfers++;
+  connection_statistics_.new_connections += num_connects;
+  if (num_connects == 0) {
+    connection_statistics_.reused_transfers++;
+  }
+}
+
 // static
 int CurlMulti::HandleSocket(
     CURL* easy, curl_socket_t socket, int action, void* userp, void* socketp) {
@@ -4,9 +4,11 @@
 #include <curl/curl.h>
 #include <memory>
 #include <set>
+#include <vector>
 
 #include "async_wrap.h"
 #include "aworker_binding.h"
+#include "binding/curl/curl_statistics.h"
 
 namespace aworker {
 namespace curl {
@@ -44,6 +46,7 @@ class CurlMulti : public AsyncWrap {
   static void OnClose(uv_handle_t* handle);
 
   void ProcessMessages();
+  void RecordConnectionStatistics(CURL* easy_handle);
 
   CurlMulti(Immortal* immortal, v8::Local<v8::Object> object);
   ~CurlMulti();
@@ -52,6 +55,9 @@ class CurlMulti : public AsyncWrap {
   uv_timer_t timer_;
   CURLM* multi_handle_;
   std::set<CurlEasy*> pending_handles_;
+
+  static ConnectionStatistics connection_statistics_;
+  friend const ConnectionStatistics& GetConnectionStatistics();
 };
 
 class CurlMultiContext {
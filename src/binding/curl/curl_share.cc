@@ -0,0 +1,116 @@
+#include "binding/curl/curl_share.h"
+#include <openssl/err.h>
+#include <openssl/pem.h>
+#include <openssl/ssl.h>
+#include <cstring>
+
+#include "debug_utils-inl.h"
+#include "util.h"
+
+namespace aworker {
+namespace curl {
+
+using per_process::Debug;
+
+static const char root_certs[] = {
+#include "binding/curl/root_certs.h"  // NOLINT(build/include_order)
+};
+
+uv_once_t CurlShare::init_once_ = UV_ONCE_INIT;
+uv_mutex_t CurlShare::locks_[CURL_LOCK_DATA_LAST];
+X509_STORE* CurlShare::root_cert_store_ = nullptr;
+CURLSH* CurlShare::share_handle_ = nullptr;
+
+// static
+void CurlShare::Initialize() {
+  uv_once(&init_once_, InitializeOnce);
+}
+
+// static
+void CurlShare::InitializeOnce() {
+  CHECK_EQ(curl_global_init(CURL_GLOBAL_ALL), 0);
+
+  root_cert_store_ = NewRootCertStore();
+
+  for (int idx = 0; idx < CURL_LOCK_DATA_LAST; idx++) {
+    CHECK_EQ(uv_mutex_init(&locks_[idx]), 0);
+  }
+  share_handle_ = curl_share_init();
+  CHECK_NOT_NULL(share_handle_);
+  curl_share_setopt(share_handle_, CURLSHOPT_LOCKFUNC, OnLock);
+  curl_share_setopt(share_handle_, CURLSHOPT_UNLOCKFUNC, OnUnlock);
+  curl_share_setopt(share_handle_, CURLSHOPT_SHARE, CURL_LOCK_DATA_DNS);
+  curl_share_setopt(share_handle_, CURLSHOPT_SHARE, CURL_LOCK_DATA_SSL_SESSION);
+}
+
+// static
+X509_STORE* CurlShare::NewRootCertStore() {
+  X509_STORE* store = X509_STORE_new();
+  CHECK_NOT_NULL(store);
+
+  BIO* bio = BIO_new_mem_buf(root_certs, strlen(root_certs));
+  CHECK_NOT_NULL(bio);
+  int count = 0;
+  X509* cert;
+  while ((cert = PEM_read_bio_X509(bio, nullptr, nullptr, nullptr)) !=
+         nullptr) {
+    if (X509_STORE_add_cert(store, cert) == 1) {
+      count++;
+    }
+    X509_free(cert);
+  }
+  BIO_free(bio);
+  // The last read always fails with PEM_R_NO_START_LINE at the end of the
+  // bundle.
+  ERR_clear_error();
+
+  Debug(DebugCategory::CURL, "root cert store built, certs: %d\n", count);
+  return store;
+}
+
+// static
+void CurlShare::Attach(CURL* easy_handle) {
+  Initialize();
+
+  // Disable the default CA file and path of curl, they would be loaded before
+  // the SSL_CTX callback otherwise.
+  curl_easy_setopt(easy_handle, CURLOPT_CAINFO, nullptr);
+  curl_easy_setopt(easy_handle, CURLOPT_CAPATH, nullptr);
+  CURLcode code =
+      curl_easy_setopt(easy_handle, CURLOPT_SSL_CTX_FUNCTION, OnSslCtx);
+  if (code != CURLE_OK) {
+    // The TLS backend doesn't expose the SSL_CTX, fallback to the PEM bundle.
+    struct curl_blob blob;
+    blob.data = const_cast<char*>(root_certs);
+    blob.len = strlen(root_certs);
+    blob.flags = CURL_BLOB_NOCOPY;
+    curl_easy_setopt(easy_handle, CURLOPT_CAINFO_BLOB, &blob);
+  }
+
+  curl_easy_setopt(easy_handle, CURLOPT_SHARE, share_handle_);
+}
+
+// static
+CURLcode CurlShare::OnSslCtx(CURL* easy_handle, void* ssl_ctx, void* userptr) {
+  SSL_CTX* ctx = static_cast<SSL_CTX*>(ssl_ctx);
+  // SSL_CTX_set_cert_store takes the ownership of the store.
+  X509_STORE_up_ref(root_cert_store_);
+  SSL_CTX_set_cert_store(ctx, root_cert_store_);
+  return CURLE_OK;
+}
+
+// static
+void CurlShare::OnLock(CURL* handle,
+                       curl_lock_data data,
+                       curl_lock_access access,
+                       void* userptr) {
+  uv_mutex_lock(&locks_[data]);
+}
+
+// static
+void CurlShare::OnUnlock(CURL* handle, curl_lock_data data, void* userptr) {
+  uv_mutex_unlock(&locks_[data]);
+}
+
+}  // namespace curl
+}  // namespace aworker
@@ -0,0 +1,66 @@
+#ifndef SRC_BINDING_CURL_CURL_SHARE_H_
+#define SRC_BINDING_CURL_CURL_SHARE_H_
+
+#include <curl/curl.h>
+#include <openssl/x509.h>
+
+#include "uv.h"
+
+namespace aworker {
+namespace curl {
+
+/**
+ * Process-wide state shared by every curl easy handle.
+ *
+ * The root certificates are parsed into one X509_STORE which is attached to
+ * the SSL_CTX of each connection, instead of letting curl parse the embedded
+ * PEM bundle on every handshake. The store is built before warm fork so that
+ * forked workers inherit it ready to use.
+ *
+ * A CURLSH handle shares the TLS session cache and the DNS cache across easy
+ * handles so that subsequent connections to a host can resume the session.
+ */
+class CurlShare {
+ public:
+  /**
+   * Prepare the shared state. Idempotent, and safe to be called from any
+   * thread.
+   */
+  static void Initialize();
+
+  /**
+   * Attach the shared certificate store and the share handle to the easy
+   * handle.
+   */
+  static void Attach(CURL* easy_handle);
+
+  static X509_STORE* root_cert_store() { return root_cert_store_; }
+  static CURLSH* share_handle() { return share_handle_; }
+
+ private:
+  CurlShare();
+  ~CurlShare();
+
+  CurlShare(const CurlShare& that);
+  CurlShare& operator=(const CurlShare& that);
+
+  static void InitializeOnce();
+  static X509_STORE* NewRootCertStore();
+
+  static CURLcode OnSslCtx(CURL* easy_handle, void* ssl_ctx, void* userptr);
+  static void OnLock(CURL* handle,
+                     curl_lock_data data,
+                     curl_lock_access access,
+                     void* userptr);
+  static void OnUnlock(CURL* handle, curl_lock_data data, void* userptr);
+
+  static uv_once_t init_once_;
+  static uv_mutex_t locks_[CURL_LOCK_DATA_LAST];
+  static X509_STORE* root_cert_store_;
+  static CURLSH* share_handle_;
+};
+
+}  // namespace curl
+}  // namespace aworker
+
+#endif  // SRC_BINDING_CURL_CURL_SHARE_H_
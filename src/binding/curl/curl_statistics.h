@@ -0,0 +1,25 @@
+#ifndef SRC_BINDING_CURL_CURL_STATISTICS_H_
+#define SRC_BINDING_CURL_CURL_STATISTICS_H_
+
+#include <cstdint>
+
+namespace aworker {
+namespace curl {
+
+/**
+ * Counters of the transfers completed by the curl fetch driver in this
+ * process. A transfer that didn't establish any new connection reused a
+ * pooled (or multiplexed) one.
+ */
+struct ConnectionStatistics {
+  uint64_t transfers = 0;
+  uint64_t new_connections = 0;
+  uint64_t reused_transfers = 0;
+};
+
+const ConnectionStatistics& GetConnectionStatistics();
+
+}  // namespace curl
+}  // namespace aworker
+
+#endif  // SRC_BINDING_CURL_CURL_STATISTICS_H_
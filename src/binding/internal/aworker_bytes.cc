@@ -8,6 +8,7 @@
 #include <locale>
 #include <string>
 
+#include "array_buffer_allocator.h"
 #include "aworker_binding.h"
 #include "binding/core/text.h"
 #include "error_handling.h"
@@ -143,7 +144,11 @@ AWORKER_METHOD(BufferEncodeHex) {
   CHECK(offset + byte_length <= bs->ByteLength());
 
   size_t dlen = byte_length * 2;
-  Local<ArrayBuffer> dab = ArrayBuffer::New(info.GetIsolate(), dlen);
+  Local<ArrayBuffer> dab;
+  {
+    ArrayBufferAllocator::NoZeroFillScope no_zero_fill_scope;
+    dab = ArrayBuffer::New(info.GetIsolate(), dlen);
+  }
   std::shared_ptr<BackingStore> dbs = dab->GetBackingStore();
 
   hex_encode(static_cast<const char*>(bs->Data()) + offset,
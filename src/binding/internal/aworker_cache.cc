@@ -1,6 +1,8 @@
 #include <city.h>
 #include <dirent.h>
+#include <errno.h>
 #include <fcntl.h>
+#include <stdio.h>
 #include <string.h>
 #include <sys/file.h>
 #include <sys/stat.h>
@@ -9,6 +11,7 @@
 #include "aworker_binding.h"
 #include "aworker_cache.h"
 #include "aworker_cache_data.h"
+#include "aworker_cache_removal.h"
 #include "command_parser.h"
 #include "debug_utils-inl.h"
 #include "error_handling.h"
@@ -31,6 +34,7 @@ using v8::Function;
 using v8::FunctionCallbackInfo;
 using v8::Global;
 using v8::HandleScope;
+using v8::Int32;
 using v8::Isolate;
 using v8::Local;
 using v8::MaybeLocal;
@@ -44,6 +48,8 @@ using v8::Value;
 #define AWORKER_MAGIC 0x736e6b69
 #define CACHE_DATA_VERSION 1
 #define CACHE_PAGE_HEADER_SIZE 10
+// Number of chunks read ahead while a page is being parsed.
+#define CACHE_PAGE_READ_AHEAD 4
 
 inline std::string CityHash128(std::string str) {
   uint128 hash = ::CityHash128(str.c_str(), str.length());
@@ -53,7 +59,7 @@ inline std::string CityHash128(std::string str) {
   return std::string(dest);
 }
 
-bool ParseCachePageHeader(UvZeroCopyInputFileStream* stream) {
+bool ParseCachePageHeader(ZeroCopyInputStream* stream) {
   CachePageHeader header;
   const void* data;
   int size;
@@ -98,7 +104,14 @@ Local<Object> CacheStorage::New(Immortal* immortal) {
 }
 
 CacheStorage::CacheStorage(Immortal* immortal, Local<Object> object)
-    : AsyncWrap(immortal, object) {}
+    : AsyncWrap(immortal, object) {
+  if (immortal->commandline_parser()->cache_storage_agent_lock()) {
+    resource_locks_error_ = ENOLCK;
+  } else if (mkdir(PathForResourceLocks(immortal).c_str(), 0777) != 0 &&
+             errno != EEXIST) {
+    resource_locks_error_ = errno;
+  }
+}
 
 void CacheStorage::List(Callback<Local<Array>> req) {
   ReadCacheStoragePage(
@@ -185,12 +198,39 @@ void CacheStorage::Ensure(std::string cacheName, Callback<bool> req) {
 }
 
 void CacheStorage::Delete(std::string cacheName, Callback<bool> req) {
-  unlink(PathForCachePage(immortal(), cacheName).c_str());
-  // TODO(chengzhong.wcz): rmdir
+  ReadCachePage(
+      cacheName,
+      [this, cacheName, req](AsyncWorkResult res,
+                             std::shared_ptr<CachePage> cache_page) mutable {
+        uint64_t cache_bytes = 0;
+        if (res.success) {
+          for (int idx = 0; idx < cache_page->entries_size(); idx++) {
+            cache_bytes += cache_page->entries(idx).size();
+          }
+        }
+        unlink(PathForCachePage(immortal(), cacheName).c_str());
+        // Move the directory out of the way so that a cache re-opened with the
+        // same name is not affected by the removal in the background.
+        std::string cache_path = PathForCache(immortal(), cacheName);
+        std::string tombstone_path =
+            cache_path + ".deleted-" + std::to_string(uv_os_getpid()) + "-" +
+            std::to_string(uv_hrtime());
+        if (rename(cache_path.c_str(), tombstone_path.c_str()) == 0) {
+          immortal()->macro_task_queue()->Enqueue(
+              std::make_unique<CacheRemovalTask>(tombstone_path),
+              MacroTaskPriority::kBackground);
+        }
+        DeleteFromCacheStoragePage(cacheName, cache_bytes, std::move(req));
+      });
+}
+
+void CacheStorage::DeleteFromCacheStoragePage(std::string cacheName,
+                                              uint64_t cache_bytes,
+                                              Callback<bool> req) {
   ReadCacheStoragePage(
       immortal(),
-      [this, cacheName, req](AsyncWorkResult res,
-                             std::shared_ptr<CacheStoragePage> page) mutable {
+      [this, cacheName, cache_bytes, req](
+          AsyncWorkResult res, std::shared_ptr<CacheStoragePage> page) mutable {
         if (!res.success) {
           req(res, false);
           return;
@@ -208,6 +248,9 @@ void CacheStorage::Delete(std::string cacheName, Callback<bool> req) {
           page->mutable_caches()->RemoveLast();
         }
         if (delete_count > 0) {
+          page->set_usage_bytes(page->usage_bytes() > cache_bytes
+                                    ? page->usage_bytes() - cache_bytes
+                                    : 0);
           WriteCacheStoragePage(
               immortal(), page, [req](AsyncWorkResult _, bool __) mutable {
                 req({true, ""}, true);
@@ -218,6 +261,30 @@ void CacheStorage::Delete(std::string cacheName, Callback<bool> req) {
       });
 }
 
+void CacheStorage::UpdateUsage(int64_t delta, Callback<uint64_t> req) {
+  ReadCacheStoragePage(
+      immortal(),
+      [this, delta, req](AsyncWorkResult res,
+                         std::shared_ptr<CacheStoragePage> page) mutable {
+        if (!res.success) {
+          page = std::make_shared<CacheStoragePage>();
+        }
+        uint64_t usage_bytes = page->usage_bytes();
+        if (delta < 0 && static_cast<uint64_t>(-delta) > usage_bytes) {
+          usage_bytes = 0;
+        } else {
+          usage_bytes += delta;
+        }
+        page->set_usage_bytes(usage_bytes);
+        WriteCacheStoragePage(
+            immortal(),
+            page,
+            [usage_bytes, req](AsyncWorkResult _, bool __) mutable {
+              req({true, ""}, usage_bytes);
+            });
+      });
+}
+
 std::string CacheStorage::PathForCacheStorage(Immortal* immortal) {
   return std::string(immortal->commandline_parser()
                          ->raw_same_origin_shared_data_dir()) +
@@ -228,6 +295,78 @@ std::string CacheStorage::PathForCacheStoragePage(Immortal* immortal) {
   return PathForCacheStorage(immortal) + ".data";
 }
 
+std::string CacheStorage::PathForResourceLocks(Immortal* immortal) {
+  return std::string(immortal->commandline_parser()
+                         ->raw_same_origin_shared_data_dir()) +
+         "/locks";
+}
+
+std::string CacheStorage::PathForResourceLock(Immortal* immortal,
+                                              std::string resourceId) {
+  return PathForResourceLocks(immortal) + "/" + CityHash128(resourceId) +
+         ".lock";
+}
+
+namespace {
+// Whether the fd is still the file at the path, i.e. the lock file has not
+// been removed by its last holder since it was opened.
+bool IsSameFile(int fd, const std::string& path) {
+  struct stat fd_stat, path_stat;
+  if (fstat(fd, &fd_stat) != 0 || stat(path.c_str(), &path_stat) != 0) {
+    return false;
+  }
+  return fd_stat.st_dev == path_stat.st_dev &&
+         fd_stat.st_ino == path_stat.st_ino;
+}
+
+int FlockNonBlocking(int fd, int operation) {
+  int r;
+  do {
+    r = flock(fd, operation | LOCK_NB);
+  } while (r != 0 && errno == EINTR);
+  return r == 0 ? 0 : -errno;
+}
+}  // namespace
+
+int CacheStorage::TryLockResource(std::string resourceId, bool exclusive) {
+  if (resource_locks_error_ != 0) {
+    return -resource_locks_error_;
+  }
+  std::string path = PathForResourceLock(immortal(), resourceId);
+  while (true) {
+    int fd = open(path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0666);
+    if (fd < 0) {
+      return -errno;
+    }
+    int err = FlockNonBlocking(fd, exclusive ? LOCK_EX : LOCK_SH);
+    if (err != 0) {
+      close(fd);
+      return err;
+    }
+    if (IsSameFile(fd, path)) {
+      return fd;
+    }
+    // The file was removed by its last holder before it was locked here,
+    // retry with the file currently at the path.
+    close(fd);
+  }
+}
+
+void CacheStorage::UnlockResource(std::string resourceId, int fd) {
+  CHECK_GE(fd, 0);
+  // Remove the lock file while holding it exclusively so that the lock files
+  // don't pile up. Lockers that opened the removed file detect it after
+  // locking and retry. A shared lock is not converted atomically, the file is
+  // simply kept if another holder takes it in the meantime.
+  std::string path = PathForResourceLock(immortal(), resourceId);
+  if (FlockNonBlocking(fd, LOCK_EX) == 0 && IsSameFile(fd, path)) {
+    unlink(path.c_str());
+  }
+  // Closing the only descriptor of the open file description releases the
+  // lock.
+  close(fd);
+}
+
 std::string CacheStorage::PathForCache(Immortal* immortal,
                                        std::string cacheName) {
   string data_dir = std::string(
@@ -309,17 +448,49 @@ void CacheStorage::WriteCacheObjectPage(std::string cacheName,
   WritePage(immortal(), cacheObjectFilename, page, req);
 }
 
+namespace {
+struct UnlinkReq {
+  uv_fs_t req;
+  Callback<bool> callback;
+};
+}  // namespace
+
+void CacheStorage::DeleteCacheObjectPage(std::string cacheObjectFilename,
+                                         Callback<bool> req) {
+  UnlinkReq* unlink_req = new UnlinkReq{uv_fs_t(), std::move(req)};
+  int err = uv_fs_unlink(
+      immortal()->event_loop(),
+      &unlink_req->req,
+      cacheObjectFilename.c_str(),
+      [](uv_fs_t* req) {
+        UnlinkReq* unlink_req = ContainerOf(&UnlinkReq::req, req);
+        int result = static_cast<int>(req->result);
+        uv_fs_req_cleanup(req);
+        if (result < 0) {
+          unlink_req->callback({false, uv_strerror(result)}, false);
+        } else {
+          unlink_req->callback({true, ""}, true);
+        }
+        delete unlink_req;
+      });
+  if (err != 0) {
+    unlink_req->callback({false, uv_strerror(err)}, false);
+    delete unlink_req;
+  }
+}
+
 template <typename T>
 void CacheStorage::ReadPage(Immortal* immortal,
                             std::string path,
                             Callback<std::shared_ptr<T>> req) {
   CallbackWrap<decltype(req)>* req_wrap =
       new CallbackWrap<decltype(req)>(std::move(req));
-  UvZeroCopyInputFileStream::Create(
+  UvStreamingZeroCopyInputFileStream::Create(
       immortal->event_loop(),
       path,
+      CACHE_PAGE_READ_AHEAD,
       [req_wrap_captured = req_wrap,
-       path](std::unique_ptr<UvZeroCopyInputFileStream> stream) {
+       path](std::unique_ptr<UvStreamingZeroCopyInputFileStream> stream) {
         // To make asan happy that we are not accessing the captured variable
         // after the lambda got released.
         CallbackWrap<decltype(req)>* req_wrap = req_wrap_captured;
@@ -336,15 +507,26 @@ void CacheStorage::ReadPage(Immortal* immortal,
           delete req_wrap;
           return;
         }
-        UvZeroCopyInputFileStream* stream_managed = stream.release();
+        UvStreamingZeroCopyInputFileStream* stream_managed = stream.release();
         shared_ptr<T> page =
             std::shared_ptr<T>(new T(), [stream_managed](T* p) {
               delete p;
               delete stream_managed;
             });
-        page->ParseFromZeroCopyStream(stream_managed);
-        req_wrap->callback({true, ""}, std::move(page));
-        delete req_wrap;
+        // The page is parsed as its chunks are read.
+        T* message = page.get();
+        stream_managed->ParseMessage(
+            message,
+            [req_wrap, page = std::move(page), path](bool success) mutable {
+              if (!success) {
+                req_wrap->callback(
+                    {false, SPrintF("unable to parse page(%s)", path)},
+                    nullptr);
+              } else {
+                req_wrap->callback({true, ""}, std::move(page));
+              }
+              delete req_wrap;
+            });
       });
 }
 
@@ -627,6 +809,88 @@ AWORKER_METHOD(WriteCacheObjectPage) {
       });
 }
 
+AWORKER_METHOD(DeleteCacheObjectPage) {
+  Immortal* immortal = Immortal::GetCurrent(info);
+  Isolate* isolate = immortal->isolate();
+  HandleScope scope(isolate);
+
+  Local<String> cache_object_filename = info[0].As<String>();
+  Global<Function>* callback =
+      new Global<Function>(isolate, info[1].As<Function>());
+
+  aworker::Utf8Value cache_object_filename_utf8(isolate, cache_object_filename);
+  immortal->cache_storage()->DeleteCacheObjectPage(
+      *cache_object_filename_utf8,
+      [immortal, callback](AsyncWorkResult result, bool success) {
+        Isolate* isolate = immortal->isolate();
+        HandleScope scope(isolate);
+
+        Local<Function> local_callback = callback->Get(isolate);
+        Local<Value> argv[1] = {Boolean::New(isolate, success)};
+        // TODO(chengzhong.wcz): proper wrap;
+        immortal->cache_storage()->MakeCallback(local_callback, 1, argv);
+        delete callback;
+      });
+}
+
+AWORKER_METHOD(UpdateCacheStorageUsage) {
+  Immortal* immortal = Immortal::GetCurrent(info);
+  Isolate* isolate = immortal->isolate();
+  HandleScope scope(isolate);
+  Local<Context> context = immortal->context();
+
+  int64_t delta = info[0]->IntegerValue(context).ToChecked();
+  Global<Function>* callback =
+      new Global<Function>(isolate, info[1].As<Function>());
+
+  immortal->cache_storage()->UpdateUsage(
+      delta,
+      [immortal, callback](AsyncWorkResult result, uint64_t usage_bytes) {
+        Isolate* isolate = immortal->isolate();
+        HandleScope scope(isolate);
+
+        Local<Function> local_callback = callback->Get(isolate);
+        Local<Value> argv[1] = {
+            Number::New(isolate, static_cast<double>(usage_bytes))};
+        // TODO(chengzhong.wcz): proper wrap;
+        immortal->cache_storage()->MakeCallback(local_callback, 1, argv);
+        delete callback;
+      });
+}
+
+/**
+ * Host-local resource locks. All workers of the same origin share the
+ * directory of --same-origin-shared-data-dir, so a flock(2) on a lock file in
+ * that directory coordinates them without a round trip to the agent.
+ *
+ * Returns the locked fd, or a negative errno. The lock is never waited on
+ * here: -EWOULDBLOCK is returned if the lock is contended and the caller is
+ * responsible for retrying.
+ */
+AWORKER_METHOD(TryLockResource) {
+  Immortal* immortal = Immortal::GetCurrent(info);
+  Isolate* isolate = immortal->isolate();
+  HandleScope scope(isolate);
+
+  Local<String> resource_id = info[0].As<String>();
+  bool exclusive = info[1]->IsTrue();
+  aworker::Utf8Value resource_id_utf8(isolate, resource_id);
+
+  info.GetReturnValue().Set(immortal->cache_storage()->TryLockResource(
+      resource_id_utf8.ToString(), exclusive));
+}
+
+AWORKER_METHOD(UnlockResource) {
+  Immortal* immortal = Immortal::GetCurrent(info);
+  Isolate* isolate = immortal->isolate();
+  HandleScope scope(isolate);
+
+  Local<String> resource_id = info[0].As<String>();
+  aworker::Utf8Value resource_id_utf8(isolate, resource_id);
+  immortal->cache_storage()->UnlockResource(resource_id_utf8.ToString(),
+                                            info[1].As<Int32>()->Value());
+}
+
 AWORKER_METHOD(InitCacheStorage) {
   Immortal* immortal = Immortal::GetCurrent(info);
   // TODO(chengzhong.wcz): put the async wrap reference to JavaScript World.
@@ -650,6 +914,15 @@ AWORKER_BINDING(Init) {
       exports, "readCacheObjectPage", ReadCacheObjectPage);
   immortal->SetFunctionProperty(
       exports, "writeCacheObjectPage", WriteCacheObjectPage);
+  immortal->SetFunctionProperty(
+      exports, "deleteCacheObjectPage", DeleteCacheObjectPage);
+
+  immortal->SetFunctionProperty(
+      exports, "updateCacheStorageUsage", UpdateCacheStorageUsage);
+
+  immortal->SetFunctionProperty(exports, "tryLockResource", TryLockResource);
+  immortal->SetFunctionProperty(exports, "unlockResource", UnlockResource);
+  immortal->SetIntegerProperty(exports, "kLockWouldBlock", -EWOULDBLOCK);
 }
 
 AWORKER_EXTERNAL_REFERENCE(Init) {
@@ -662,6 +935,10 @@ AWORKER_EXTERNAL_REFERENCE(Init) {
   registry->Register(WriteCachePage);
   registry->Register(ReadCacheObjectPage);
   registry->Register(WriteCacheObjectPage);
+  registry->Register(DeleteCacheObjectPage);
+  registry->Register(UpdateCacheStorageUsage);
+  registry->Register(TryLockResource);
+  registry->Register(UnlockResource);
 }
 
 }  // namespace cache
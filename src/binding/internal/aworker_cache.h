@@ -47,6 +47,8 @@ class CacheStorage : public AsyncWrap {
   void Ensure(std::string cacheName, Callback<bool> callback);
   // Async.
   void Delete(std::string cacheName, Callback<bool> callback);
+  // Async. Adjust the accounted bytes of the origin.
+  void UpdateUsage(int64_t delta, Callback<uint64_t> callback);
 
   void ReadCachePage(std::string cacheName,
                      Callback<std::shared_ptr<CachePage>> callback);
@@ -60,6 +62,9 @@ class CacheStorage : public AsyncWrap {
                             std::string cacheObjectFilename,
                             std::shared_ptr<CacheObjectPage> page,
                             Callback<bool> callback);
+  // Async.
+  void DeleteCacheObjectPage(std::string cacheObjectFilename,
+                             Callback<bool> callback);
 
   static v8::Local<v8::Object> New(Immortal* immortal);
   static std::string PathForCacheObjectPage(Immortal* immortal,
@@ -68,8 +73,16 @@ class CacheStorage : public AsyncWrap {
   static std::string PathForCacheObjectPage(Immortal* immortal,
                                             std::string cacheName,
                                             CachedEntry* request);
+  static std::string PathForResourceLock(Immortal* immortal,
+                                         std::string resourceId);
+  // Returns the locked fd or a negative errno.
+  int TryLockResource(std::string resourceId, bool exclusive);
+  // Releases the lock, and removes the lock file if no one else is holding
+  // it.
+  void UnlockResource(std::string resourceId, int fd);
 
  private:
+  static std::string PathForResourceLocks(Immortal* immortal);
   static std::string PathForCacheStorage(Immortal* immortal);
   static std::string PathForCacheStoragePage(Immortal* immortal);
   static std::string PathForCache(Immortal* immortal, std::string cacheName);
@@ -92,6 +105,12 @@ class CacheStorage : public AsyncWrap {
                         std::string path,
                         std::shared_ptr<T> page,
                         Callback<bool>);
+  void DeleteFromCacheStoragePage(std::string cacheName,
+                                  uint64_t cache_bytes,
+                                  Callback<bool> callback);
+
+  // Errno of the local resource locks being unavailable, or 0.
+  int resource_locks_error_ = 0;
 };
 
 }  // namespace cache
@@ -0,0 +1,39 @@
+#include "aworker_cache_removal.h"
+#include <dirent.h>
+#include <errno.h>
+#include <string.h>
+#include <unistd.h>
+
+namespace aworker {
+namespace cache {
+
+#define REMOVAL_MAX_UNLINK_PER_TICK 16
+
+CacheRemovalTask::CacheRemovalTask(std::string path)
+    : MacroTask(), path_(path) {}
+
+void CacheRemovalTask::OnWorkTick() {
+  DIR* dir = opendir(path_.c_str());
+  if (dir == nullptr) {
+    Fail("unable to open cache directory");
+    return;
+  }
+  int unlinked = 0;
+  struct dirent* ent;
+  while (unlinked < REMOVAL_MAX_UNLINK_PER_TICK &&
+         (ent = readdir(dir)) != nullptr) {
+    if (strcmp(ent->d_name, ".") == 0 || strcmp(ent->d_name, "..") == 0) {
+      continue;
+    }
+    unlink((path_ + "/" + ent->d_name).c_str());
+    unlinked++;
+  }
+  closedir(dir);
+  if (unlinked == 0) {
+    rmdir(path_.c_str());
+    Done();
+  }
+}
+
+}  // namespace cache
+}  // namespace aworker
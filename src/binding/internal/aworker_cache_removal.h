@@ -0,0 +1,27 @@
+#ifndef SRC_BINDING_INTERNAL_AWORKER_CACHE_REMOVAL_H_
+#define SRC_BINDING_INTERNAL_AWORKER_CACHE_REMOVAL_H_
+#include <string>
+
+#include "macro_task_queue.h"
+
+namespace aworker {
+namespace cache {
+
+/**
+ * Removes the files of a deleted cache directory, a bounded number of files
+ * per tick, and finally the directory itself.
+ */
+class CacheRemovalTask : public MacroTask {
+ public:
+  explicit CacheRemovalTask(std::string path);
+
+  void OnWorkTick() override;
+
+ private:
+  std::string path_;
+};
+
+}  // namespace cache
+}  // namespace aworker
+
+#endif  // SRC_BINDING_INTERNAL_AWORKER_CACHE_REMOVAL_H_
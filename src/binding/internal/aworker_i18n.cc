@@ -1,5 +1,6 @@
 #include <iostream>
 
+#include "array_buffer_allocator.h"
 #include "aworker_platform.h"
 #include "error_handling.h"
 #include "immortal.h"
@@ -222,7 +223,11 @@ AWORKER_METHOD(EncodeUtf8) {
 
   Local<String> str = info[0].As<String>();
   size_t length = str->Utf8Length(isolate);
-  Local<ArrayBuffer> ab = ArrayBuffer::New(isolate, length);
+  Local<ArrayBuffer> ab;
+  {
+    ArrayBufferAllocator::NoZeroFillScope no_zero_fill_scope;
+    ab = ArrayBuffer::New(isolate, length);
+  }
 
   char* buf = static_cast<char*>(ab->GetBackingStore()->Data());
   str->WriteUtf8(isolate,
@@ -27,6 +27,12 @@ using v8::String;
 using v8::TryCatch;
 using v8::Value;
 
+/**
+ * The single check handle of an immortal. JavaScript keeps the immediate
+ * queue and drains it in one `onimmediate` callback. The check handle itself
+ * is unref'd, the idle handle is started while there are ref'd immediates to
+ * keep the loop alive and prevent it from blocking on polling.
+ */
 class ImmediateWrap : public HandleWrap {
   DEFINE_WRAPPERTYPEINFO();
   SIZE_IN_BYTES(ImmediateWrap);
@@ -50,7 +56,10 @@ class ImmediateWrap : public HandleWrap {
     auto prototype_template = tpl->PrototypeTemplate();
     tpl->SetClassName(name);
     immortal->SetFunctionProperty(
-        prototype_template, "remove", ImmediateWrap::Remove);
+        prototype_template, "schedule", ImmediateWrap::Schedule);
+    immortal->SetFunctionProperty(prototype_template, "ref", ImmediateWrap::Ref);
+    immortal->SetFunctionProperty(
+        prototype_template, "unref", ImmediateWrap::Unref);
 
     exports->Set(context, name, tpl->GetFunction(context).ToLocalChecked())
         .Check();
@@ -58,13 +67,14 @@ class ImmediateWrap : public HandleWrap {
 
   static void Init(ExternalReferenceRegistry* registry) {
     registry->Register(ImmediateWrap::New);
-    registry->Register(ImmediateWrap::Remove);
+    registry->Register(ImmediateWrap::Schedule);
+    registry->Register(ImmediateWrap::Ref);
+    registry->Register(ImmediateWrap::Unref);
   }
 
   static AWORKER_METHOD(New) {
     Immortal* immortal = Immortal::GetCurrent(info);
     auto isolate = immortal->isolate();
-    auto context = immortal->context();
     HandleScope scope(isolate);
 
     CHECK_EQ(info.Length(), 0);
@@ -74,24 +84,31 @@ class ImmediateWrap : public HandleWrap {
     info.GetReturnValue().Set(info.This());
   }
 
-  static AWORKER_METHOD(Remove) {
-    Immortal* immortal = Immortal::GetCurrent(info);
-    auto isolate = immortal->isolate();
-    HandleScope scope(isolate);
+  static AWORKER_METHOD(Schedule) {
+    ImmediateWrap* wrap;
+    ASSIGN_OR_RETURN_UNWRAP(&wrap, info.This());
+    wrap->pending_ = true;
+  }
+
+  static AWORKER_METHOD(Ref) {
     ImmediateWrap* wrap;
     ASSIGN_OR_RETURN_UNWRAP(&wrap, info.This());
-    wrap->MakeWeak();
+    uv_idle_start(&wrap->idle, [](uv_idle_t* idle) { /* idling */ });
+  }
 
+  static AWORKER_METHOD(Unref) {
+    ImmediateWrap* wrap;
+    ASSIGN_OR_RETURN_UNWRAP(&wrap, info.This());
     uv_idle_stop(&wrap->idle);
-    uv_check_stop(&wrap->check);
   }
 
   ImmediateWrap(Immortal* immortal, Local<Object> object)
-      : HandleWrap(immortal, object, reinterpret_cast<uv_handle_t*>(&check)) {
+      : HandleWrap(immortal, object, reinterpret_cast<uv_handle_t*>(&check)),
+        pending_(false) {
     uv_check_init(immortal->event_loop(), &check);
     uv_idle_init(immortal->event_loop(), &idle);
-    uv_idle_start(&idle, [](uv_idle_t* idle) { /* idling */ });
     uv_check_start(&check, TriggerImmediate);
+    uv_unref(reinterpret_cast<uv_handle_t*>(&check));
   }
 
   ~ImmediateWrap() = default;
@@ -104,16 +121,30 @@ class ImmediateWrap : public HandleWrap {
  private:
   static void TriggerImmediate(uv_check_t* check) {
     ImmediateWrap* handle = ContainerOf(&ImmediateWrap::check, check);
-    auto isolate = handle->immortal()->isolate();
-    HandleScope scope(isolate);
-    handle->MakeCallback(handle->immortal()->onimmediate_string(), 0, nullptr);
-
-    uv_idle_stop(&handle->idle);
-    uv_check_stop(&handle->check);
+    if (!handle->pending_) {
+      return;
+    }
+    handle->pending_ = false;
+
+    Immortal* immortal = handle->immortal();
+    HandleScope scope(immortal->isolate());
+    MaybeLocal<Value> ret;
+    // Immediate callbacks may throw. The exceptions are routed to the global
+    // scope by the verbose TryCatch, and the rest of the queue is drained by
+    // calling into JavaScript again.
+    do {
+      TryCatchScope try_catch(immortal);
+      try_catch.SetVerbose(true);
+      ret = handle->MakeCallback(immortal->onimmediate_string(), 0, nullptr);
+      if (try_catch.HasTerminated()) {
+        return;
+      }
+    } while (ret.IsEmpty());
   }
 
   uv_check_t check;
   uv_idle_t idle;
+  bool pending_;
 };
 
 const WrapperTypeInfo ImmediateWrap::wrapper_type_info_{
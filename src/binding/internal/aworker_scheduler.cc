@@ -0,0 +1,141 @@
+#include "async_wrap.h"
+#include "aworker_binding.h"
+#include "immortal.h"
+#include "macro_task_queue.h"
+#include "util.h"
+
+namespace aworker {
+namespace Scheduler {
+
+using v8::FunctionCallbackInfo;
+using v8::FunctionTemplate;
+using v8::HandleScope;
+using v8::Local;
+using v8::Object;
+using v8::String;
+using v8::Value;
+
+/**
+ * A task posted by `scheduler.postTask`. The wrap is kept alive by the macro
+ * task queue until the task has run, the `ontask` callback is skipped if the
+ * task has been aborted in the meantime.
+ */
+class SchedulerTaskWrap : public AsyncWrap {
+  DEFINE_WRAPPERTYPEINFO();
+  SIZE_IN_BYTES(SchedulerTaskWrap)
+  SET_NO_MEMORY_INFO()
+
+ public:
+  static void Init(Local<Object> exports) {
+    Immortal* immortal = Immortal::GetCurrent(exports->CreationContext());
+    auto isolate = immortal->isolate();
+    HandleScope scope(isolate);
+    auto context = immortal->context();
+
+    Local<FunctionTemplate> tpl =
+        FunctionTemplate::New(isolate, SchedulerTaskWrap::New);
+    tpl->Inherit(AsyncWrap::GetConstructorTemplate(immortal));
+    tpl->InstanceTemplate()->SetInternalFieldCount(
+        BaseObject::kInternalFieldCount);
+
+    Local<String> name = OneByteString(isolate, "SchedulerTaskWrap");
+
+    auto prototype_template = tpl->PrototypeTemplate();
+    tpl->SetClassName(name);
+    immortal->SetFunctionProperty(
+        prototype_template, "abort", SchedulerTaskWrap::Abort);
+
+    exports->Set(context, name, tpl->GetFunction(context).ToLocalChecked())
+        .Check();
+
+#define V(name, priority)                                                      \
+  immortal->SetIntegerProperty(                                                \
+      exports, name, static_cast<int>(MacroTaskPriority::priority));
+    V("PRIORITY_USER_BLOCKING", kUserBlocking)
+    V("PRIORITY_USER_VISIBLE", kUserVisible)
+    V("PRIORITY_BACKGROUND", kBackground)
+#undef V
+  }
+
+  static void Init(ExternalReferenceRegistry* registry) {
+    registry->Register(SchedulerTaskWrap::New);
+    registry->Register(SchedulerTaskWrap::Abort);
+  }
+
+  static AWORKER_METHOD(New) {
+    Immortal* immortal = Immortal::GetCurrent(info);
+    HandleScope scope(immortal->isolate());
+
+    CHECK(info.Length() >= 1 && info[0]->IsInt32());
+    int priority = info[0].As<v8::Int32>()->Value();
+    CHECK(priority >= 0 &&
+          priority < static_cast<int>(MacroTaskPriority::kCount));
+
+    new SchedulerTaskWrap(
+        immortal, info.This(), static_cast<MacroTaskPriority>(priority));
+
+    info.GetReturnValue().Set(info.This());
+  }
+
+  static AWORKER_METHOD(Abort) {
+    SchedulerTaskWrap* wrap;
+    ASSIGN_OR_RETURN_UNWRAP(&wrap, info.This());
+    // The pending macro task still references the wrap, it is made weak once
+    // the task has been dequeued.
+    wrap->aborted_ = true;
+  }
+
+  SchedulerTaskWrap(Immortal* immortal,
+                    Local<Object> object,
+                    MacroTaskPriority priority)
+      : AsyncWrap(immortal, object), aborted_(false) {
+    immortal->macro_task_queue()->Enqueue(std::make_unique<Task>(this),
+                                          priority);
+  }
+
+  ~SchedulerTaskWrap() = default;
+
+ private:
+  class Task : public MacroTask {
+   public:
+    explicit Task(SchedulerTaskWrap* wrap) : MacroTask(), wrap_(wrap) {}
+
+    void OnWorkTick() override {
+      Done();
+      wrap_->Run();
+    }
+
+   private:
+    SchedulerTaskWrap* wrap_;
+  };
+
+  void Run() {
+    if (!aborted_) {
+      HandleScope scope(immortal()->isolate());
+      // Exceptions of the callback are routed to the global scope.
+      MakeCallback(immortal()->ontask_string(), 0, nullptr);
+    }
+    MakeWeak();
+  }
+
+  bool aborted_;
+};
+
+const WrapperTypeInfo SchedulerTaskWrap::wrapper_type_info_{
+    "scheduler_task_wrap",
+};
+
+AWORKER_BINDING(Init) {
+  SchedulerTaskWrap::Init(exports);
+}
+
+AWORKER_EXTERNAL_REFERENCE(Init) {
+  SchedulerTaskWrap::Init(registry);
+}
+
+}  // namespace Scheduler
+}  // namespace aworker
+
+AWORKER_BINDING_REGISTER(scheduler,
+                         aworker::Scheduler::Init,
+                         aworker::Scheduler::Init)
@@ -1,6 +1,7 @@
 #include <cmath>
 
 #include "aworker_binding.h"
+#include "command_parser_group.h"
 #include "error_handling.h"
 #include "handle_wrap.h"
 #include "immortal.h"
@@ -27,6 +28,11 @@ using v8::String;
 using v8::TryCatch;
 using v8::Value;
 
+/**
+ * The single libuv timer of an immortal. JavaScript keeps the timer lists and
+ * schedules the wrap to the earliest expiry, all the due timers are fired in
+ * one `ontimeout` callback.
+ */
 class TimerWrap : public HandleWrap {
   DEFINE_WRAPPERTYPEINFO();
   SIZE_IN_BYTES(TimerWrap)
@@ -50,7 +56,11 @@ class TimerWrap : public HandleWrap {
     auto prototype_template = tpl->PrototypeTemplate();
     tpl->SetClassName(name);
     immortal->SetFunctionProperty(
-        prototype_template, "remove", TimerWrap::Remove);
+        prototype_template, "schedule", TimerWrap::Schedule);
+    immortal->SetFunctionProperty(prototype_template, "stop", TimerWrap::Stop);
+    immortal->SetFunctionProperty(prototype_template, "ref", TimerWrap::Ref);
+    immortal->SetFunctionProperty(
+        prototype_template, "unref", TimerWrap::Unref);
 
     exports->Set(context, name, tpl->GetFunction(context).ToLocalChecked())
         .Check();
@@ -58,48 +68,69 @@ class TimerWrap : public HandleWrap {
 
   static void Init(ExternalReferenceRegistry* registry) {
     registry->Register(TimerWrap::New);
-    registry->Register(TimerWrap::Remove);
+    registry->Register(TimerWrap::Schedule);
+    registry->Register(TimerWrap::Stop);
+    registry->Register(TimerWrap::Ref);
+    registry->Register(TimerWrap::Unref);
   }
 
   static AWORKER_METHOD(New) {
     Immortal* immortal = Immortal::GetCurrent(info);
-    auto isolate = immortal->isolate();
+    HandleScope scope(immortal->isolate());
+
+    new TimerWrap(immortal, info.This());
+
+    info.GetReturnValue().Set(info.This());
+  }
+
+  static AWORKER_METHOD(Schedule) {
+    Immortal* immortal = Immortal::GetCurrent(info);
     auto context = immortal->context();
-    HandleScope scope(isolate);
+    HandleScope scope(immortal->isolate());
+    TimerWrap* wrap;
+    ASSIGN_OR_RETURN_UNWRAP(&wrap, info.This());
 
-    CHECK(info.Length() >= 2 && info[0]->IsNumber() && info[1]->IsBoolean());
+    CHECK(info.Length() >= 1 && info[0]->IsNumber());
+    int64_t duration = info[0]->IntegerValue(context).FromJust();
+    if (duration < 0) {
+      duration = 0;
+    }
+    // Round the expiry up to the slack bucket, so that timers expiring in the
+    // same bucket are fired in one wakeup.
+    int64_t slack = immortal->commandline_parser()->timer_slack_ms();
+    if (slack > 0) {
+      int64_t now = static_cast<int64_t>(uv_now(immortal->event_loop()));
+      int64_t expiry = (now + duration + slack - 1) / slack * slack;
+      duration = expiry - now;
+    }
+
+    uv_timer_start(&wrap->timer, TriggerTimer, duration, 0);
+  }
 
-    Local<Number> interval = info[0].As<Number>();
-    Local<Boolean> is_loop = info[1].As<Boolean>();
+  static AWORKER_METHOD(Stop) {
+    TimerWrap* wrap;
+    ASSIGN_OR_RETURN_UNWRAP(&wrap, info.This());
 
-    Maybe<int> maybe_interval = interval->Int32Value(context);
-    CHECK(maybe_interval.IsJust());
-    int int_interval = maybe_interval.FromJust();
-    bool bool_is_loop = is_loop->BooleanValue(isolate);
+    uv_timer_stop(&wrap->timer);
+  }
 
-    new TimerWrap(immortal, info.This(), bool_is_loop, int_interval);
+  static AWORKER_METHOD(Ref) {
+    TimerWrap* wrap;
+    ASSIGN_OR_RETURN_UNWRAP(&wrap, info.This());
 
-    info.GetReturnValue().Set(info.This());
+    uv_ref(reinterpret_cast<uv_handle_t*>(&wrap->timer));
   }
 
-  static AWORKER_METHOD(Remove) {
-    Immortal* immortal = Immortal::GetCurrent(info);
-    auto isolate = immortal->isolate();
-    HandleScope scope(isolate);
+  static AWORKER_METHOD(Unref) {
     TimerWrap* wrap;
     ASSIGN_OR_RETURN_UNWRAP(&wrap, info.This());
-    wrap->MakeWeak();
 
-    uv_timer_stop(&wrap->timer);
+    uv_unref(reinterpret_cast<uv_handle_t*>(&wrap->timer));
   }
 
-  TimerWrap(Immortal* immortal,
-            Local<Object> object,
-            bool repeat,
-            uint64_t interval)
+  TimerWrap(Immortal* immortal, Local<Object> object)
       : HandleWrap(immortal, object, reinterpret_cast<uv_handle_t*>(&timer)) {
     uv_timer_init(immortal->event_loop(), &timer);
-    uv_timer_start(&timer, TriggerTimer, interval, repeat ? interval : 0);
   }
 
   ~TimerWrap() = default;
@@ -107,12 +138,26 @@ class TimerWrap : public HandleWrap {
  private:
   static void TriggerTimer(uv_timer_t* timer) {
     TimerWrap* handle = ContainerOf(&TimerWrap::timer, timer);
-    auto isolate = handle->immortal()->isolate();
+    Immortal* immortal = handle->immortal();
+    auto isolate = immortal->isolate();
     HandleScope scope(isolate);
-
-    // Timer callback may throw. However those exceptions were routed to global
-    // scope, we don't care about the return value here;
-    handle->MakeCallback(handle->immortal()->ontimeout_string(), 0, nullptr);
+    immortal->loop_statistics()->timer_wakeups++;
+
+    Local<Value> argv[] = {
+        Number::New(isolate, static_cast<double>(uv_now(timer->loop)))};
+    MaybeLocal<Value> ret;
+    // Timer callbacks may throw. The exceptions are routed to the global scope
+    // by the verbose TryCatch, and the remaining due timers are processed by
+    // calling into JavaScript again.
+    do {
+      TryCatchScope try_catch(immortal);
+      try_catch.SetVerbose(true);
+      ret = handle->MakeCallback(
+          immortal->ontimeout_string(), arraysize(argv), argv);
+      if (try_catch.HasTerminated()) {
+        return;
+      }
+    } while (ret.IsEmpty());
   }
 
   uv_timer_t timer;
@@ -122,12 +167,20 @@ const WrapperTypeInfo TimerWrap::wrapper_type_info_{
     "timer_wrap",
 };
 
+AWORKER_METHOD(GetLibuvNow) {
+  Immortal* immortal = Immortal::GetCurrent(info);
+  double now = static_cast<double>(uv_now(immortal->event_loop()));
+  info.GetReturnValue().Set(now);
+}
+
 AWORKER_BINDING(Init) {
   TimerWrap::Init(exports);
+  immortal->SetFunctionProperty(exports, "getLibuvNow", GetLibuvNow);
 }
 
 AWORKER_EXTERNAL_REFERENCE(Init) {
   TimerWrap::Init(registry);
+  registry->Register(GetLibuvNow);
 }
 
 }  // namespace Timers
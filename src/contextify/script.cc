@@ -1,4 +1,5 @@
 #include "script.h"
+#include "array_buffer_allocator.h"
 #include "util.h"
 
 namespace aworker {
@@ -114,7 +115,10 @@ AWORKER_METHOD(ScriptWrap::CreateCachedData) {
   if (cached_data == nullptr) {
     cached_data_buffer = ArrayBuffer::New(isolate, cached_data->length);
   } else {
-    cached_data_buffer = ArrayBuffer::New(isolate, cached_data->length);
+    {
+      ArrayBufferAllocator::NoZeroFillScope no_zero_fill_scope;
+      cached_data_buffer = ArrayBuffer::New(isolate, cached_data->length);
+    }
     std::shared_ptr<BackingStore> backing_store =
         cached_data_buffer->GetBackingStore();
     memcpy(backing_store->Data(), cached_data->data, cached_data->length);
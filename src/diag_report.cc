@@ -18,6 +18,7 @@
 #include "command_parser.h"
 #include "debug_utils.h"
 
+#include "array_buffer_allocator.h"
 #include "aworker_version.h"
 #include "diag_report.h"
 #include "json_utils.h"
@@ -78,6 +79,8 @@ static void PrintJavaScriptErrorProperties(JSONWriter* writer,
                                            Local<Value> error);
 static void PrintNativeStack(JSONWriter* writer);
 static void PrintGCStatistics(JSONWriter* writer, Isolate* isolate);
+static void PrintArrayBufferAllocatorStatistics(JSONWriter* writer,
+                                                Isolate* isolate);
 static void PrintUvLoopResources(JSONWriter* writer, Immortal* immortal);
 static void PrintResourceUsage(JSONWriter* writer, Immortal* immortal);
 static void PrintSystemInformation(JSONWriter* writer);
@@ -259,6 +262,9 @@ static void WriteDiagReport(Isolate* isolate,
   // Report V8 Heap and Garbage Collector information
   PrintGCStatistics(&writer, isolate);
 
+  // Report ArrayBuffer allocator information
+  PrintArrayBufferAllocatorStatistics(&writer, isolate);
+
   // Report libuv resource usage
   PrintUvLoopResources(&writer, immortal);
 
@@ -506,6 +512,21 @@ static void PrintGCStatistics(JSONWriter* writer, Isolate* isolate) {
   writer->json_objectend();
 }
 
+// Report ArrayBuffer allocations and the buffers retained by the allocator.
+static void PrintArrayBufferAllocatorStatistics(JSONWriter* writer,
+                                                Isolate* isolate) {
+  writer->json_objectstart("arrayBufferAllocator");
+  ArrayBufferAllocator* allocator = ArrayBufferAllocator::From(isolate);
+  if (allocator != nullptr) {
+    ArrayBufferAllocator::Statistics stats = allocator->GetStatistics();
+    writer->json_keyvalue("allocations", stats.allocations);
+    writer->json_keyvalue("pooledAllocations", stats.pooled_allocations);
+    writer->json_keyvalue("allocatedMemory", stats.allocated_bytes);
+    writer->json_keyvalue("pooledMemory", stats.pooled_bytes);
+  }
+  writer->json_objectend();
+}
+
 static void PrintUvLoopResources(JSONWriter* writer, Immortal* immortal) {
   writer->json_arraystart("libuv");
   if (immortal != nullptr) {
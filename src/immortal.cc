@@ -1,4 +1,5 @@
 #include "immortal.h"
+#include <algorithm>
 #include "agent_channel/noslated_data_channel.h"
 #include "agent_channel/noslated_diag_channel.h"
 #include "aworker.h"
@@ -23,6 +24,7 @@
 #include "util.h"
 #include "utils/async_primitives.h"
 #include "v8-profiler.h"
+#include "zlib/zlib_stream_pool.h"
 
 namespace aworker {
 
@@ -206,8 +208,12 @@ Immortal::Immortal(uv_loop_t* loop,
       env_vars_(std::make_shared<ProcessEnvStore>()),
       cache_storage_(nullptr),
       callback_scope_stack_top_(nullptr),
-      macro_task_queue_(MacroTaskQueue::Create(
-          loop, options->max_macro_task_count_per_tick())),
+      macro_task_queue_(
+          MacroTaskQueue::Create(loop,
+                                 options->max_macro_task_count_per_tick(),
+                                 options->macro_task_time_budget_us())),
+      zlib_stream_pool_(std::make_shared<zlib::ZlibStreamPool>(
+          std::max(options->zlib_stream_pool_size(), 0))),
       isolate_data_(isolate_data) {
   inspector_agent_ = std::make_shared<inspector::InspectorAgent>(this);
   interrupt_async_ = UvAsync<std::function<void()>>::Create(
@@ -242,6 +248,8 @@ Immortal::Immortal(uv_loop_t* loop,
 }
 
 Immortal::~Immortal() {
+  isolate_->RemoveGCEpilogueCallback(zlib::ZlibStreamPool::OnGCEpilogue,
+                                     zlib_stream_pool_.get());
   uv_close(reinterpret_cast<uv_handle_t*>(&prepare_handle_), nullptr);
   uv_close(reinterpret_cast<uv_handle_t*>(&check_handle_), nullptr);
   StopAgent();
@@ -520,6 +528,9 @@ void Immortal::InitializeIsolate() {
   isolate_->SetMicrotasksPolicy(v8::MicrotasksPolicy::kExplicit);
   isolate_->GetHeapProfiler()->AddBuildEmbedderGraphCallback(BuildEmbedderGraph,
                                                              this);
+  isolate_->AddGCEpilogueCallback(zlib::ZlibStreamPool::OnGCEpilogue,
+                                  zlib_stream_pool_.get(),
+                                  v8::kGCTypeMarkSweepCompact);
 }
 
 void Immortal::InitializeDefaultContext() {
@@ -768,6 +779,7 @@ void Immortal::OnPrepare(uv_prepare_t* handle) {
 void Immortal::OnCheck(uv_check_t* handle) {
   Immortal* immortal = ContainerOf(&Immortal::check_handle_, handle);
   immortal->isolate()->SetIdle(false);
+  immortal->loop_statistics_.wakeups++;
 }
 
 }  // namespace aworker
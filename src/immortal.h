@@ -25,6 +25,9 @@ class CommandlineParserGroup;
 namespace cache {
 class CacheStorage;
 }
+namespace zlib {
+class ZlibStreamPool;
+}
 class CallbackScope;
 
 class AgentDataChannel;
@@ -123,7 +126,8 @@ class KVStore {
   V(std::shared_ptr<KVStore>, env_vars)                                        \
   V(cache::CacheStorage*, cache_storage)                                       \
   V(CallbackScope*, callback_scope_stack_top)                                  \
-  V(std::shared_ptr<MacroTaskQueue>, macro_task_queue)
+  V(std::shared_ptr<MacroTaskQueue>, macro_task_queue)                         \
+  V(std::shared_ptr<zlib::ZlibStreamPool>, zlib_stream_pool)
 
 #define IMMORTAL_GLOBAL_PROPERTIES(V)                                          \
   V(v8::FunctionTemplate, base_object_ctor_template)                           \
@@ -165,6 +169,7 @@ class KVStore {
   V(message, "message")                                                        \
   V(name, "name")                                                              \
   V(onimmediate, "onimmediate")                                                \
+  V(ontask, "ontask")                                                          \
   V(ontimeout, "ontimeout")                                                    \
   V(on_signal, "onSignal")                                                     \
   V(openssl_error_stack, "opensslErrorStack")                                  \
@@ -342,6 +347,16 @@ class Immortal : public MemoryRetainer {
     return loop_latency_watchdog_.get();
   }
 
+  /**
+   * Counters of the event loop wakeups, i.e. the returns from polling for IO,
+   * and of the ones caused by the expiry of the JavaScript timers.
+   */
+  struct LoopStatistics {
+    uint64_t wakeups = 0;
+    uint64_t timer_wakeups = 0;
+  };
+  inline LoopStatistics* loop_statistics() { return &loop_statistics_; }
+
   std::set<binding::Binding*> loaded_internal_bindings;
   std::set<std::string> loaded_native_modules_with_cache;
   std::set<std::string> loaded_native_modules_without_cache;
@@ -375,6 +390,7 @@ class Immortal : public MemoryRetainer {
 
   uv_prepare_t prepare_handle_;
   uv_check_t check_handle_;
+  LoopStatistics loop_statistics_;
 };
 
 #undef IMMORTAL_DECLARE_PROPERTY
@@ -1,17 +1,37 @@
 #include "macro_task_queue.h"
 #include "debug_utils.h"
+#include "tracing/trace_event.h"
 
 namespace aworker {
 
+// Weight of the latest slice in the moving average, in 1/8.
+#define SLICE_ESTIMATE_WEIGHT 2
+
+namespace {
+// A task waiting longer than this is processed before the tasks with higher
+// priorities.
+const uint64_t kAgingNs[] = {
+    0,                      // kUserBlocking
+    100 * 1000 * 1000,      // kUserVisible
+    1000 * 1000 * 1000,     // kBackground
+};
+}  // namespace
+
 std::shared_ptr<MacroTaskQueue> MacroTaskQueue::Create(uv_loop_t* loop,
-                                                       int max_tick_per_loop) {
+                                                       int max_tick_per_loop,
+                                                       int time_budget_us) {
   return std::shared_ptr<MacroTaskQueue>(
-      new MacroTaskQueue(loop, max_tick_per_loop),
+      new MacroTaskQueue(loop, max_tick_per_loop, time_budget_us),
       FunctionDeleter<MacroTaskQueue, Dispose>());
 }
 
-MacroTaskQueue::MacroTaskQueue(uv_loop_t* loop, int max_tick_per_loop)
-    : loop_(loop), max_tick_per_loop_(max_tick_per_loop), active_(false) {
+MacroTaskQueue::MacroTaskQueue(uv_loop_t* loop,
+                               int max_tick_per_loop,
+                               int time_budget_us)
+    : loop_(loop),
+      max_tick_per_loop_(max_tick_per_loop),
+      time_budget_us_(time_budget_us),
+      active_(false) {
   uv_idle_init(loop, &idle_);
 }
 
@@ -22,16 +42,83 @@ void MacroTaskQueue::TickMacroTaskQueue(uv_idle_t* handle) {
   queue->TickMacroTaskQueue();
 }
 
+bool MacroTaskQueue::ShouldYield(int processed,
+                                 uint64_t deadline,
+                                 const MacroTask* next) {
+  if (time_budget_us_ <= 0) {
+    return processed >= max_tick_per_loop_;
+  }
+  // Always make progress.
+  if (processed == 0) {
+    return false;
+  }
+  return uv_hrtime() + next->_estimated_slice_ns > deadline;
+}
+
+std::queue<MacroTaskQueue::Entry>* MacroTaskQueue::NextQueue(uint64_t now) {
+  std::queue<Entry>* next = nullptr;
+  for (int idx = 0; idx < static_cast<int>(MacroTaskPriority::kCount); idx++) {
+    std::queue<Entry>* queue = &queues_[idx];
+    if (queue->empty()) {
+      continue;
+    }
+    if (next == nullptr) {
+      next = queue;
+      continue;
+    }
+    if (now - queue->front().enqueued_at > kAgingNs[idx]) {
+      return queue;
+    }
+  }
+  return next;
+}
+
+void MacroTaskQueue::Push(std::unique_ptr<MacroTask> task,
+                          uint64_t enqueued_at) {
+  int priority = static_cast<int>(task->_priority);
+  queues_[priority].push({std::move(task), enqueued_at});
+}
+
+size_t MacroTaskQueue::size() {
+  size_t size = 0;
+  for (const std::queue<Entry>& queue : queues_) {
+    size += queue.size();
+  }
+  return size;
+}
+
 void MacroTaskQueue::TickMacroTaskQueue() {
+  TRACE_EVENT0(TRACING_CATEGORY_AWORKER1(macro_task_queue),
+               "TickMacroTaskQueue");
   int processed = 0;
+  uint64_t deadline =
+      uv_hrtime() + static_cast<uint64_t>(time_budget_us_) * 1000;
 
   per_process::Debug(DebugCategory::MACRO_TASK_QUEUE,
                      "process macro task queue, %zu\n",
-                     queue_.size());
-  while (processed < max_tick_per_loop_ && !queue_.empty()) {
-    std::unique_ptr<MacroTask> task = std::move(queue_.front());
-    queue_.pop();
-    task->OnWorkTick();
+                     size());
+  while (true) {
+    std::queue<Entry>* queue = NextQueue(uv_hrtime());
+    if (queue == nullptr ||
+        ShouldYield(processed, deadline, queue->front().task.get())) {
+      break;
+    }
+    std::unique_ptr<MacroTask> task = std::move(queue->front().task);
+    uint64_t enqueued_at = queue->front().enqueued_at;
+    queue->pop();
+    {
+      TRACE_EVENT0(TRACING_CATEGORY_AWORKER1(macro_task_queue),
+                   "MacroTaskSlice");
+      uint64_t start = uv_hrtime();
+      task->OnWorkTick();
+      uint64_t duration = uv_hrtime() - start;
+      task->_estimated_slice_ns =
+          task->_estimated_slice_ns == 0
+              ? duration
+              : (task->_estimated_slice_ns * (8 - SLICE_ESTIMATE_WEIGHT) +
+                 duration * SLICE_ESTIMATE_WEIGHT) /
+                    8;
+    }
     if (task->is_done() || task->has_error()) {
       per_process::Debug(DebugCategory::MACRO_TASK_QUEUE,
                          "macro task done with is_done: %d, has_error: %d\n",
@@ -42,14 +129,16 @@ void MacroTaskQueue::TickMacroTaskQueue() {
     } else {
       per_process::Debug(DebugCategory::MACRO_TASK_QUEUE,
                          "macro task re-queuing\n");
-      queue_.push(std::move(task));
+      // Keep the original enqueue time so that a multi-slice task keeps
+      // aging until it is done.
+      Push(std::move(task), enqueued_at);
     }
     processed++;
   }
   per_process::Debug(
       DebugCategory::MACRO_TASK_QUEUE, "macro task processed %d\n", processed);
 
-  if (queue_.empty()) {
+  if (size() == 0) {
     uv_idle_stop(&idle_);
     active_ = false;
     return;
@@ -59,9 +148,13 @@ void MacroTaskQueue::TickMacroTaskQueue() {
   active_ = true;
 }
 
-void MacroTaskQueue::Enqueue(std::unique_ptr<MacroTask> task) {
-  per_process::Debug(DebugCategory::MACRO_TASK_QUEUE, "macro task enqueue\n");
-  queue_.push(std::move(task));
+void MacroTaskQueue::Enqueue(std::unique_ptr<MacroTask> task,
+                             MacroTaskPriority priority) {
+  per_process::Debug(DebugCategory::MACRO_TASK_QUEUE,
+                     "macro task enqueue with priority %d\n",
+                     static_cast<int>(priority));
+  task->_priority = priority;
+  Push(std::move(task), uv_hrtime());
   if (active_) {
     return;
   }
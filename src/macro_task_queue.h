@@ -9,7 +9,23 @@
 
 namespace aworker {
 
+class MacroTaskQueue;
+
+/**
+ * Priorities of the WICG prioritized task scheduling API. Tasks with higher
+ * priorities are processed first, while tasks waiting for too long are aged
+ * to avoid starvation.
+ */
+enum class MacroTaskPriority {
+  kUserBlocking = 0,
+  kUserVisible,
+  kBackground,
+  kCount,
+};
+
 class MacroTask {
+  friend class MacroTaskQueue;
+
  public:
   inline MacroTask() : _is_done(false), _is_error(false) {}
   virtual inline ~MacroTask() {}
@@ -31,6 +47,12 @@ class MacroTask {
   bool _is_done;
   bool _is_error;
   std::string _error;
+
+ private:
+  // Moving average of the slice durations, used to predict whether the next
+  // slice fits in the time budget of the current tick.
+  uint64_t _estimated_slice_ns = 0;
+  MacroTaskPriority _priority = MacroTaskPriority::kUserVisible;
 };
 
 class MacroTaskQueue {
@@ -46,24 +68,43 @@ class MacroTaskQueue {
   }
 
  public:
+  /**
+   * If `time_budget_us` is positive, each tick processes tasks until the
+   * budget is used up, otherwise at most `max_tick_per_loop` tasks are
+   * processed in each tick.
+   */
   static std::shared_ptr<MacroTaskQueue> Create(uv_loop_t* loop,
-                                                int max_tick_per_loop);
-  void Enqueue(std::unique_ptr<MacroTask> task);
+                                                int max_tick_per_loop,
+                                                int time_budget_us = 0);
+  void Enqueue(
+      std::unique_ptr<MacroTask> task,
+      MacroTaskPriority priority = MacroTaskPriority::kUserVisible);
 
   inline int max_tick_per_loop() { return max_tick_per_loop_; }
+  inline int time_budget_us() { return time_budget_us_; }
   inline bool active() { return active_; }
 
  private:
-  MacroTaskQueue(uv_loop_t* loop, int max_tick_per_loop);
+  MacroTaskQueue(uv_loop_t* loop, int max_tick_per_loop, int time_budget_us);
   ~MacroTaskQueue();
   static void TickMacroTaskQueue(uv_idle_t* handle);
   void TickMacroTaskQueue();
+  bool ShouldYield(int processed, uint64_t deadline, const MacroTask* next);
+
+  struct Entry {
+    std::unique_ptr<MacroTask> task;
+    uint64_t enqueued_at;
+  };
+  std::queue<Entry>* NextQueue(uint64_t now);
+  void Push(std::unique_ptr<MacroTask> task, uint64_t enqueued_at);
+  size_t size();
 
   uv_loop_t* loop_;
   uv_idle_t idle_;
   int max_tick_per_loop_;
+  int time_budget_us_;
   bool active_;
-  std::queue<std::unique_ptr<MacroTask>> queue_;
+  std::queue<Entry> queues_[static_cast<int>(MacroTaskPriority::kCount)];
 };
 
 }  // namespace aworker
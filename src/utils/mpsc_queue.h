@@ -0,0 +1,80 @@
+#pragma once
+
+#include <atomic>
+
+#include "util.h"
+
+namespace aworker {
+
+class MpscQueueNode {
+ public:
+  inline MpscQueueNode() : mpsc_next_(nullptr) {}
+
+ private:
+  template <typename T>
+  friend class MpscQueue;
+
+  std::atomic<MpscQueueNode*> mpsc_next_;
+};
+
+/**
+ * Intrusive multi-producer single-consumer queue, refer to
+ * https://www.1024cores.net/home/lock-free-algorithms/queues/intrusive-mpsc-node-based-queue
+ *
+ * `Push` is wait-free and can be called from any thread, `Pop` must only be
+ * called from the consumer thread. `Pop` may return nullptr while a producer
+ * is in the middle of a `Push`, the producer is expected to notify the
+ * consumer after the `Push` returned.
+ *
+ * The queue doesn't own the nodes, they must be popped before the queue is
+ * destroyed.
+ */
+template <typename T>
+class MpscQueue {
+ public:
+  inline MpscQueue() : head_(&stub_), tail_(&stub_) {}
+  AWORKER_DISALLOW_ASSIGN_COPY(MpscQueue);
+
+  inline void Push(T* item) { Push(static_cast<MpscQueueNode*>(item)); }
+
+  inline T* Pop() {
+    MpscQueueNode* tail = tail_;
+    MpscQueueNode* next = tail->mpsc_next_.load(std::memory_order_acquire);
+    if (tail == &stub_) {
+      if (next == nullptr) {
+        return nullptr;
+      }
+      tail_ = next;
+      tail = next;
+      next = next->mpsc_next_.load(std::memory_order_acquire);
+    }
+    if (next != nullptr) {
+      tail_ = next;
+      return static_cast<T*>(tail);
+    }
+    if (tail != head_.load(std::memory_order_acquire)) {
+      // A producer is pushing.
+      return nullptr;
+    }
+    Push(&stub_);
+    next = tail->mpsc_next_.load(std::memory_order_acquire);
+    if (next != nullptr) {
+      tail_ = next;
+      return static_cast<T*>(tail);
+    }
+    return nullptr;
+  }
+
+ private:
+  inline void Push(MpscQueueNode* node) {
+    node->mpsc_next_.store(nullptr, std::memory_order_relaxed);
+    MpscQueueNode* prev = head_.exchange(node, std::memory_order_acq_rel);
+    prev->mpsc_next_.store(node, std::memory_order_release);
+  }
+
+  std::atomic<MpscQueueNode*> head_;
+  MpscQueueNode* tail_;
+  MpscQueueNode stub_;
+};
+
+}  // namespace aworker
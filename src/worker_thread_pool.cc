@@ -0,0 +1,254 @@
+#include "worker_thread_pool.h"
+#include <algorithm>
+#include <chrono>  // NOLINT(build/c++11)
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+#include "debug_utils.h"
+#include "utils/async_primitives.h"
+#include "uv.h"
+
+namespace aworker {
+
+using std::unique_ptr;
+
+namespace {
+// Worker index of the current thread, or -1 if the current thread is not a
+// worker thread.
+thread_local int current_worker_index = -1;
+
+inline uint64_t now_in_ns() {
+  return uv_hrtime();
+}
+
+#ifdef __linux__
+// Returns the CPU bandwidth quota of the cgroup in CPUs, or a negative
+// value if the quota is not limited.
+double GetCgroupCpuQuota() {
+  // cgroup v2
+  FILE* fp = fopen("/sys/fs/cgroup/cpu.max", "r");
+  if (fp != nullptr) {
+    char quota[32];
+    long long period = 0;  // NOLINT(runtime/int)
+    int matched = fscanf(fp, "%31s %lld", quota, &period);
+    fclose(fp);
+    if (matched != 2 || strcmp(quota, "max") == 0 || period <= 0) {
+      return -1;
+    }
+    return atoll(quota) / static_cast<double>(period);
+  }
+
+  // cgroup v1
+  for (const char* dir : {"/sys/fs/cgroup/cpu", "/sys/fs/cgroup/cpu,cpuacct"}) {
+    long long quota = 0;   // NOLINT(runtime/int)
+    long long period = 0;  // NOLINT(runtime/int)
+    std::string base(dir);
+    fp = fopen((base + "/cpu.cfs_quota_us").c_str(), "r");
+    if (fp == nullptr) {
+      continue;
+    }
+    int matched = fscanf(fp, "%lld", &quota);
+    fclose(fp);
+    fp = fopen((base + "/cpu.cfs_period_us").c_str(), "r");
+    if (fp == nullptr) {
+      continue;
+    }
+    matched += fscanf(fp, "%lld", &period);
+    fclose(fp);
+    if (matched != 2 || quota <= 0 || period <= 0) {
+      return -1;
+    }
+    return quota / static_cast<double>(period);
+  }
+  return -1;
+}
+
+std::vector<int> GetAffinityCpus() {
+  std::vector<int> cpus;
+  cpu_set_t set;
+  CPU_ZERO(&set);
+  if (sched_getaffinity(0, sizeof(set), &set) != 0) {
+    return cpus;
+  }
+  for (int cpu = 0; cpu < CPU_SETSIZE; cpu++) {
+    if (CPU_ISSET(cpu, &set)) {
+      cpus.push_back(cpu);
+    }
+  }
+  return cpus;
+}
+#endif  // __linux__
+}  // namespace
+
+int GetAvailableParallelism() {
+  int cpus = std::thread::hardware_concurrency();
+#ifdef __linux__
+  std::vector<int> affinity_cpus = GetAffinityCpus();
+  if (!affinity_cpus.empty()) {
+    cpus = affinity_cpus.size();
+  }
+  double quota = GetCgroupCpuQuota();
+  if (quota > 0) {
+    cpus = std::min(cpus, static_cast<int>(std::ceil(quota)));
+  }
+#endif
+  return std::max(cpus, 1);
+}
+
+WorkerThreadPool::WorkerThreadPool(int thread_count, bool thread_affinity) {
+  CHECK_GT(thread_count, 0);
+  std::vector<int> cpus;
+#ifdef __linux__
+  if (thread_affinity) {
+    cpus = GetAffinityCpus();
+  }
+#endif
+  for (int idx = 0; idx < thread_count; idx++) {
+    workers_.emplace_back(std::make_unique<Worker>());
+  }
+  for (int idx = 0; idx < thread_count; idx++) {
+    int cpu = cpus.empty() ? -1 : cpus[idx % cpus.size()];
+    workers_[idx]->thread =
+        std::thread(&WorkerThreadPool::WorkerMain, this, idx, cpu);
+  }
+  delayed_thread_ = std::thread(&WorkerThreadPool::DelayedTaskMain, this);
+  per_process::Debug(DebugCategory::PLATFORM,
+                     "worker thread pool started, threads: %d, affinity: %d\n",
+                     thread_count,
+                     !cpus.empty());
+}
+
+WorkerThreadPool::~WorkerThreadPool() {
+  {
+    ScopedLock lock(delayed_mutex_);
+    delayed_stopped_ = true;
+  }
+  delayed_cv_.notify_all();
+  delayed_thread_.join();
+
+  {
+    ScopedLock lock(idle_mutex_);
+    stopped_ = true;
+  }
+  idle_cv_.notify_all();
+  for (auto& worker : workers_) {
+    worker->thread.join();
+  }
+}
+
+void WorkerThreadPool::PostTask(unique_ptr<v8::Task> task) {
+  size_t index = current_worker_index >= 0
+                     ? current_worker_index
+                     : next_worker_.fetch_add(1, std::memory_order_relaxed) %
+                           workers_.size();
+  Push(index, std::move(task));
+}
+
+void WorkerThreadPool::PostDelayedTask(unique_ptr<v8::Task> task,
+                                       double delay_in_seconds) {
+  uint64_t deadline = now_in_ns() + std::llround(delay_in_seconds * 1e9);
+  {
+    ScopedLock lock(delayed_mutex_);
+    delayed_tasks_.push({deadline, std::move(task)});
+  }
+  delayed_cv_.notify_one();
+}
+
+void WorkerThreadPool::Push(size_t index, unique_ptr<v8::Task> task) {
+  Worker* worker = workers_[index].get();
+  {
+    ScopedLock lock(worker->mutex);
+    worker->tasks.push_back(std::move(task));
+  }
+  pending_.fetch_add(1, std::memory_order_release);
+  {
+    // Synchronize with the workers going to sleep so that the notification
+    // is not lost.
+    ScopedLock lock(idle_mutex_);
+  }
+  idle_cv_.notify_one();
+}
+
+unique_ptr<v8::Task> WorkerThreadPool::Pop(size_t index) {
+  unique_ptr<v8::Task> task;
+  {
+    Worker* worker = workers_[index].get();
+    ScopedLock lock(worker->mutex);
+    if (!worker->tasks.empty()) {
+      task = std::move(worker->tasks.back());
+      worker->tasks.pop_back();
+    }
+  }
+  for (size_t offset = 1; task == nullptr && offset < workers_.size();
+       offset++) {
+    Worker* victim = workers_[(index + offset) % workers_.size()].get();
+    ScopedLock lock(victim->mutex);
+    if (!victim->tasks.empty()) {
+      task = std::move(victim->tasks.front());
+      victim->tasks.pop_front();
+    }
+  }
+  if (task != nullptr) {
+    pending_.fetch_sub(1, std::memory_order_acq_rel);
+  }
+  return task;
+}
+
+void WorkerThreadPool::WorkerMain(size_t index, int cpu) {
+  current_worker_index = index;
+#ifdef __linux__
+  if (cpu >= 0) {
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+  }
+#endif
+
+  while (true) {
+    unique_ptr<v8::Task> task = Pop(index);
+    if (task != nullptr) {
+      task->Run();
+      continue;
+    }
+    UniqueLock lock(idle_mutex_);
+    idle_cv_.wait(lock, [this]() {
+      return stopped_ || pending_.load(std::memory_order_acquire) > 0;
+    });
+    if (stopped_) {
+      return;
+    }
+  }
+}
+
+void WorkerThreadPool::DelayedTaskMain() {
+  UniqueLock lock(delayed_mutex_);
+  while (!delayed_stopped_) {
+    if (delayed_tasks_.empty()) {
+      delayed_cv_.wait(lock);
+      continue;
+    }
+    uint64_t now = now_in_ns();
+    uint64_t deadline = delayed_tasks_.top().deadline;
+    if (deadline > now) {
+      delayed_cv_.wait_for(lock, std::chrono::nanoseconds(deadline - now));
+      continue;
+    }
+    unique_ptr<v8::Task> task =
+        std::move(const_cast<DelayedTask&>(delayed_tasks_.top()).task);
+    delayed_tasks_.pop();
+    lock.unlock();
+    PostTask(std::move(task));
+    lock.lock();
+  }
+}
+
+}  // namespace aworker
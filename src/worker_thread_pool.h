@@ -0,0 +1,94 @@
+#ifndef SRC_WORKER_THREAD_POOL_H_
+#define SRC_WORKER_THREAD_POOL_H_
+
+#include <atomic>
+#include <condition_variable>  // NOLINT(build/c++11)
+#include <deque>
+#include <memory>
+#include <mutex>  // NOLINT(build/c++11)
+#include <queue>
+#include <thread>  // NOLINT(build/c++11)
+#include <vector>
+
+#include "util.h"
+#include "v8.h"
+
+namespace aworker {
+
+/**
+ * Number of CPUs the process can actually run on, i.e. the CPU affinity mask
+ * bounded by the cgroup (v1 or v2) CPU bandwidth quota, instead of the host
+ * core count.
+ */
+int GetAvailableParallelism();
+
+/**
+ * Work-stealing thread pool running the worker thread tasks of the threaded
+ * platform.
+ *
+ * Each worker owns a deque. Tasks posted from a worker are pushed to its own
+ * deque, and tasks posted from other threads are distributed to the deques
+ * in a round-robin fashion. A worker pops the tasks of its own deque in LIFO
+ * order, and steals the oldest tasks of the other deques once its own deque
+ * is drained.
+ *
+ * Delayed tasks are kept in a heap by a dedicated thread, and are posted to
+ * the workers once their deadlines are met.
+ */
+class WorkerThreadPool {
+ public:
+  WorkerThreadPool(int thread_count, bool thread_affinity);
+  ~WorkerThreadPool();
+  AWORKER_DISALLOW_ASSIGN_COPY(WorkerThreadPool);
+
+  void PostTask(std::unique_ptr<v8::Task> task);
+  void PostDelayedTask(std::unique_ptr<v8::Task> task,
+                       double delay_in_seconds);
+
+  inline int thread_count() const { return workers_.size(); }
+
+ private:
+  struct Worker {
+    std::mutex mutex;
+    std::deque<std::unique_ptr<v8::Task>> tasks;
+    std::thread thread;
+  };
+
+  struct DelayedTask {
+    uint64_t deadline;
+    std::unique_ptr<v8::Task> task;
+  };
+
+  struct DelayedTaskCompare {
+    bool operator()(const DelayedTask& lhs, const DelayedTask& rhs) const {
+      return lhs.deadline > rhs.deadline;
+    }
+  };
+
+  void WorkerMain(size_t index, int cpu);
+  void DelayedTaskMain();
+  void Push(size_t index, std::unique_ptr<v8::Task> task);
+  std::unique_ptr<v8::Task> Pop(size_t index);
+
+  std::vector<std::unique_ptr<Worker>> workers_;
+  std::atomic<size_t> next_worker_{0};
+  // Count of the tasks in the deques.
+  std::atomic<size_t> pending_{0};
+
+  std::mutex idle_mutex_;
+  std::condition_variable idle_cv_;
+  bool stopped_ = false;
+
+  std::mutex delayed_mutex_;
+  std::condition_variable delayed_cv_;
+  std::priority_queue<DelayedTask,
+                      std::vector<DelayedTask>,
+                      DelayedTaskCompare>
+      delayed_tasks_;
+  bool delayed_stopped_ = false;
+  std::thread delayed_thread_;
+};
+
+}  // namespace aworker
+
+#endif  // SRC_WORKER_THREAD_POOL_H_
@@ -2,14 +2,115 @@
 #include <errno.h>
 #include <fcntl.h>
 #include <unistd.h>
+#include <google/protobuf/io/coded_stream.h>
+#include <algorithm>
+#include <climits>
 
 #include "aworker_logger.h"
 #include "debug_utils.h"
 #include "util.h"
 
 #define MAX_PIPE_PAGE 65536
+#define MAX_WRITE_BUFS 64
+#define MAX_FREE_BUFS 16
+#define MAX_VARINT_SIZE 10
+// A tag followed by the length of a length-delimited field.
+#define MAX_FIELD_HEADER_SIZE (2 * MAX_VARINT_SIZE)
+#define FIELD_INCOMPLETE 0
+#define FIELD_INVALID SIZE_MAX
 
 namespace aworker {
+
+namespace {
+// Buffers of finished writes are reused by the following writes on the same
+// thread instead of being re-allocated.
+class ZeroCopyStreamBufPool {
+ public:
+  ~ZeroCopyStreamBufPool() {
+    for (char* it : free_) {
+      delete[] it;
+    }
+  }
+
+  char* Acquire() {
+    if (free_.empty()) {
+      return new char[MAX_PIPE_PAGE];
+    }
+    char* it = free_.back();
+    free_.pop_back();
+    return it;
+  }
+
+  // Takes the ownership of the data of the buffer if the pool is not full.
+  void Release(ZeroCopyStreamBuf* buf) {
+    if (buf->data == nullptr || free_.size() >= MAX_FREE_BUFS) {
+      return;
+    }
+    free_.push_back(buf->data);
+    buf->data = nullptr;
+  }
+
+ private:
+  std::vector<char*> free_;
+};
+
+thread_local ZeroCopyStreamBufPool buf_pool;
+
+// Returns the size of the varint, 0 if it is incomplete, or -1 if it is
+// invalid.
+int ReadVarint(const uint8_t* data, size_t size, uint64_t* value) {
+  *value = 0;
+  for (size_t idx = 0; idx < size && idx < MAX_VARINT_SIZE; idx++) {
+    *value |= static_cast<uint64_t>(data[idx] & 0x7f) << (7 * idx);
+    if ((data[idx] & 0x80) == 0) {
+      return idx + 1;
+    }
+  }
+  return size >= MAX_VARINT_SIZE ? -1 : 0;
+}
+
+// Returns the length of the protobuf field starting at `data`, which may be
+// larger than `size`, FIELD_INCOMPLETE if the field header is not complete
+// yet, or FIELD_INVALID.
+size_t FieldLength(const char* data, size_t size) {
+  const uint8_t* bytes = reinterpret_cast<const uint8_t*>(data);
+  uint64_t tag;
+  int tag_size = ReadVarint(bytes, size, &tag);
+  if (tag_size <= 0) {
+    return tag_size < 0 ? FIELD_INVALID : FIELD_INCOMPLETE;
+  }
+  if ((tag >> 3) == 0) {
+    return FIELD_INVALID;
+  }
+  uint64_t value;
+  int value_size;
+  switch (tag & 0x7) {
+    case 0:  // varint
+      value_size = ReadVarint(bytes + tag_size, size - tag_size, &value);
+      if (value_size <= 0) {
+        return value_size < 0 ? FIELD_INVALID : FIELD_INCOMPLETE;
+      }
+      return tag_size + value_size;
+    case 1:  // fixed64
+      return tag_size + 8;
+    case 2:  // length-delimited
+      value_size = ReadVarint(bytes + tag_size, size - tag_size, &value);
+      if (value_size <= 0) {
+        return value_size < 0 ? FIELD_INVALID : FIELD_INCOMPLETE;
+      }
+      if (value > INT_MAX) {
+        return FIELD_INVALID;
+      }
+      return tag_size + value_size + value;
+    case 5:  // fixed32
+      return tag_size + 4;
+    default:
+      // Groups are not used.
+      return FIELD_INVALID;
+  }
+}
+}  // namespace
+
 void UvZeroCopyInputFileStream::Create(uv_loop_t* loop,
                                        std::string path,
                                        Callback callback) {
@@ -117,17 +218,339 @@ int64_t UvZeroCopyInputFileStream::ByteCount() const {
   return count;
 }
 
+struct UvStreamingZeroCopyInputFileStream::SharedState {
+  explicit SharedState(uv_file fd) : fd(fd) {}
+  // Closed once both the stream and all the pending reads are gone.
+  ~SharedState() {
+    uv_fs_t close_req;
+    uv_fs_close(nullptr, &close_req, fd, nullptr);
+    uv_fs_req_cleanup(&close_req);
+  }
+
+  uv_file fd;
+  // Reset once the stream is destroyed, only accessed on the loop thread.
+  UvStreamingZeroCopyInputFileStream* stream = nullptr;
+};
+
+struct UvStreamingZeroCopyInputFileStream::Chunk {
+  Chunk(std::shared_ptr<SharedState> state, int64_t offset, int len)
+      : state(state), offset(offset), buf(new char[len], len) {}
+
+  uv_work_t work;
+  std::shared_ptr<SharedState> state;
+  int64_t offset;
+  ZeroCopyStreamBuf buf;
+  // Written on the threadpool, and only read on the loop thread once `ready`
+  // is set in the after work callback.
+  ssize_t nread = 0;
+  bool ready = false;
+};
+
+struct UvStreamingZeroCopyInputFileStream::OpenReq {
+  uv_fs_t req;
+  std::string path;
+  int read_ahead;
+  Callback callback;
+};
+
+void UvStreamingZeroCopyInputFileStream::Create(uv_loop_t* loop,
+                                                std::string path,
+                                                int read_ahead,
+                                                Callback callback) {
+  CHECK_GT(read_ahead, 0);
+  OpenReq* open_req = new OpenReq{uv_fs_t(), path, read_ahead, callback};
+  int err = uv_fs_open(
+      loop, &open_req->req, open_req->path.c_str(), O_RDONLY, 0, OpenCb);
+  if (err < 0) {
+    uv_fs_req_cleanup(&open_req->req);
+    DLOG("UvStreamingZeroCopyInputFileStream::Create(%s): %s",
+         path.c_str(),
+         uv_strerror(err));
+    delete open_req;
+    callback(nullptr);
+  }
+}
+
+void UvStreamingZeroCopyInputFileStream::OpenCb(uv_fs_t* req) {
+  std::unique_ptr<OpenReq> open_req(ContainerOf(&OpenReq::req, req));
+  const uv_file fd = static_cast<uv_file>(req->result);
+  uv_loop_t* loop = req->loop;
+  uv_fs_req_cleanup(req);
+  if (fd < 0) {
+    DLOG("UvStreamingZeroCopyInputFileStream::Create(%s): %s",
+         open_req->path.c_str(),
+         uv_strerror(fd));
+    open_req->callback(nullptr);
+    return;
+  }
+  auto ptr = new UvStreamingZeroCopyInputFileStream(
+      loop, fd, open_req->read_ahead, std::move(open_req->callback));
+  ptr->ReadAhead();
+}
+
+UvStreamingZeroCopyInputFileStream::UvStreamingZeroCopyInputFileStream(
+    uv_loop_t* loop, uv_file fd, int read_ahead, Callback callback)
+    : ZeroCopyInputStream(),
+      loop_(loop),
+      read_ahead_(read_ahead),
+      state_(std::make_shared<SharedState>(fd)),
+      callback_(callback) {
+  state_->stream = this;
+}
+
+UvStreamingZeroCopyInputFileStream::~UvStreamingZeroCopyInputFileStream() {
+  state_->stream = nullptr;
+}
+
+void UvStreamingZeroCopyInputFileStream::ReadWork(uv_work_t* req) {
+  Chunk* chunk = static_cast<std::shared_ptr<Chunk>*>(req->data)->get();
+  uv_buf_t buf = uv_buf_init(chunk->buf.data, chunk->buf.len);
+  uv_fs_t read_req;
+  chunk->nread = uv_fs_read(
+      nullptr, &read_req, chunk->state->fd, &buf, 1, chunk->offset, nullptr);
+  uv_fs_req_cleanup(&read_req);
+}
+
+void UvStreamingZeroCopyInputFileStream::AfterReadWork(uv_work_t* req,
+                                                       int status) {
+  std::unique_ptr<std::shared_ptr<Chunk>> holder(
+      static_cast<std::shared_ptr<Chunk>*>(req->data));
+  Chunk* chunk = holder->get();
+  chunk->ready = true;
+  UvStreamingZeroCopyInputFileStream* stream = chunk->state->stream;
+  if (stream != nullptr) {
+    stream->OnChunkRead(chunk);
+  }
+}
+
+void UvStreamingZeroCopyInputFileStream::OnChunkRead(Chunk* chunk) {
+  if (chunk->nread < chunk->buf.len) {
+    // Either failed or reached the end of the file, no more reads are needed.
+    eof_ = true;
+  }
+  if (callback_) {
+    if (chunks_.front().get() != chunk) {
+      return;
+    }
+    // The stream may be destroyed in the callback.
+    Callback callback = std::move(callback_);
+    callback_ = nullptr;
+    callback(std::unique_ptr<UvStreamingZeroCopyInputFileStream>(this));
+    return;
+  }
+  if (readable_callback_ && IsReadable()) {
+    // The stream may be destroyed in the callback.
+    std::function<void()> callback = std::move(readable_callback_);
+    readable_callback_ = nullptr;
+    callback();
+  }
+}
+
+void UvStreamingZeroCopyInputFileStream::ReadAhead() {
+  while (!eof_ && chunks_.size() < static_cast<size_t>(read_ahead_)) {
+    auto chunk =
+        std::make_shared<Chunk>(state_, fs_read_offset_, MAX_PIPE_PAGE);
+    fs_read_offset_ += MAX_PIPE_PAGE;
+    // The pending work holds a reference to the chunk so that the stream can
+    // be destroyed at any time.
+    chunk->work.data = new std::shared_ptr<Chunk>(chunk);
+    CHECK_EQ(uv_queue_work(loop_, &chunk->work, ReadWork, AfterReadWork), 0);
+    chunks_.push_back(std::move(chunk));
+  }
+}
+
+bool UvStreamingZeroCopyInputFileStream::IsReadable() {
+  return chunks_.empty() || chunks_.front()->ready;
+}
+
+void UvStreamingZeroCopyInputFileStream::Wait(std::function<void()> callback) {
+  CHECK(!readable_callback_);
+  if (IsReadable()) {
+    callback();
+    return;
+  }
+  readable_callback_ = std::move(callback);
+}
+
+void UvStreamingZeroCopyInputFileStream::ParseMessage(
+    MessageLite* message, std::function<void(bool)> callback) {
+  CHECK_NULL(parse_message_);
+  parse_message_ = message;
+  parse_callback_ = std::move(callback);
+  ParseAvailableFields();
+}
+
+void UvStreamingZeroCopyInputFileStream::ParseAvailableFields() {
+  const void* data;
+  int size;
+  while (Next(&data, &size)) {
+    if (!ParseFields(static_cast<const char*>(data), size)) {
+      FinishParsing(false);
+      return;
+    }
+  }
+  if (would_block_) {
+    Wait([this]() { ParseAvailableFields(); });
+    return;
+  }
+  FinishParsing(error_ == 0 && pending_field_.empty() &&
+                parse_message_->IsInitialized());
+}
+
+// Serialized messages are concatenations of their fields, and merging the
+// fields one at a time is equivalent to parsing the whole message.
+bool UvStreamingZeroCopyInputFileStream::ParseFields(const char* data,
+                                                      size_t size) {
+  while (size > 0) {
+    size_t count;
+    if (!pending_field_.empty() && pending_field_length_ == FIELD_INCOMPLETE) {
+      // Complete the header of the pending field first.
+      count = std::min(size, static_cast<size_t>(MAX_FIELD_HEADER_SIZE));
+      pending_field_.append(data, count);
+      size_t length = FieldLength(pending_field_.data(), pending_field_.size());
+      if (length == FIELD_INVALID) {
+        return false;
+      }
+      if (length != FIELD_INCOMPLETE && length < pending_field_.size()) {
+        // Leave the bytes of the following fields in the chunk.
+        count -= pending_field_.size() - length;
+        pending_field_.resize(length);
+      }
+      pending_field_length_ = length;
+    } else if (!pending_field_.empty()) {
+      count = std::min(size, pending_field_length_ - pending_field_.size());
+      pending_field_.append(data, count);
+    } else {
+      size_t length = FieldLength(data, size);
+      if (length == FIELD_INVALID) {
+        return false;
+      }
+      if (length != FIELD_INCOMPLETE && length <= size) {
+        if (!MergeField(data, length)) {
+          return false;
+        }
+        data += length;
+        size -= length;
+        continue;
+      }
+      // The field spans the following chunks.
+      count = size;
+      pending_field_.assign(data, count);
+      pending_field_length_ = length;
+    }
+    data += count;
+    size -= count;
+
+    if (pending_field_length_ != FIELD_INCOMPLETE &&
+        pending_field_.size() == pending_field_length_) {
+      if (!MergeField(pending_field_.data(), pending_field_.size())) {
+        return false;
+      }
+      pending_field_.clear();
+      pending_field_.shrink_to_fit();
+      pending_field_length_ = FIELD_INCOMPLETE;
+    }
+  }
+  return true;
+}
+
+bool UvStreamingZeroCopyInputFileStream::MergeField(const char* data,
+                                                     size_t size) {
+  google::protobuf::io::CodedInputStream input(
+      reinterpret_cast<const uint8_t*>(data), static_cast<int>(size));
+  return parse_message_->MergePartialFromCodedStream(&input) &&
+         input.ConsumedEntireMessage();
+}
+
+void UvStreamingZeroCopyInputFileStream::FinishParsing(bool success) {
+  parse_message_ = nullptr;
+  pending_field_.clear();
+  pending_field_length_ = FIELD_INCOMPLETE;
+  std::function<void(bool)> callback = std::move(parse_callback_);
+  parse_callback_ = nullptr;
+  // The stream may be destroyed in the callback.
+  callback(success);
+}
+
+bool UvStreamingZeroCopyInputFileStream::Next(const void** data, int* size) {
+  CHECK_NE(data, nullptr);
+  CHECK_NE(size, nullptr);
+  would_block_ = false;
+  if (backup_count_ > 0) {
+    *data = current_->buf.data + current_->nread - backup_count_;
+    *size = backup_count_;
+    byte_count_ += backup_count_;
+    backup_count_ = 0;
+    return true;
+  }
+  current_.reset();
+  if (chunks_.empty()) {
+    return false;
+  }
+  if (!chunks_.front()->ready) {
+    would_block_ = true;
+    return false;
+  }
+
+  std::shared_ptr<Chunk> chunk = std::move(chunks_.front());
+  chunks_.pop_front();
+  if (chunk->nread < 0) {
+    ELOG("Read error: %s", uv_strerror(chunk->nread));
+    error_ = chunk->nread;
+    eof_ = true;
+    chunks_.clear();
+    return false;
+  }
+  if (chunk->nread < chunk->buf.len) {
+    // Chunks following a short read are beyond the end of the file.
+    eof_ = true;
+    chunks_.clear();
+  } else {
+    ReadAhead();
+  }
+  if (chunk->nread == 0) {
+    return false;
+  }
+
+  current_ = std::move(chunk);
+  *data = current_->buf.data;
+  *size = current_->nread;
+  byte_count_ += current_->nread;
+  return true;
+}
+
+void UvStreamingZeroCopyInputFileStream::BackUp(int count) {
+  CHECK_NE(current_, nullptr);
+  CHECK_LE(count, current_->nread);
+  backup_count_ = count;
+  byte_count_ -= count;
+}
+
+bool UvStreamingZeroCopyInputFileStream::Skip(int count) {
+  const void* data;
+  int size;
+  while (count > 0) {
+    if (!Next(&data, &size)) {
+      return false;
+    }
+    if (size > count) {
+      BackUp(size - count);
+      return true;
+    }
+    count -= size;
+  }
+  return true;
+}
+
+int64_t UvStreamingZeroCopyInputFileStream::ByteCount() const {
+  return byte_count_;
+}
+
 void UvZeroCopyOutputFileStream::DisposeAndDelete(
     UvZeroCopyOutputFileStream* stream) {
   stream->waiting_for_dispose_ = true;
   if (!stream->waiting_for_write_) {
-    uv_fs_t close_req;
-    // TODO(chengzhong.wcz): async close;
-    uv_fs_close(stream->loop_, &close_req, stream->fd_, nullptr);
-    uv_fs_req_cleanup(&close_req);
-
-    stream->on_end_(stream);
-    delete stream;
+    stream->MaybeEnd();
   }
 }
 
@@ -135,6 +558,14 @@ UvZeroCopyOutputFileStream::UvZeroCopyOutputFileStreamPtr
 UvZeroCopyOutputFileStream::Create(uv_loop_t* loop,
                                    std::string path,
                                    Callback on_end) {
+  return Create(loop, path, Options(), on_end);
+}
+
+UvZeroCopyOutputFileStream::UvZeroCopyOutputFileStreamPtr
+UvZeroCopyOutputFileStream::Create(uv_loop_t* loop,
+                                   std::string path,
+                                   Options options,
+                                   Callback on_end) {
   unlink(path.c_str());
 
   uv_fs_t open_req;
@@ -146,7 +577,7 @@ UvZeroCopyOutputFileStream::Create(uv_loop_t* loop,
     ELOG("Create out %s: %s", path.c_str(), strerror(errno));
     return nullptr;
   }
-  auto ptr = new UvZeroCopyOutputFileStream(loop, fd, on_end);
+  auto ptr = new UvZeroCopyOutputFileStream(loop, fd, options, on_end);
   return UvZeroCopyOutputFileStreamPtr(ptr);
 }
 
@@ -163,42 +594,100 @@ void UvZeroCopyOutputFileStream::WriteCb(uv_fs_t* req) {
   }
 
   stream->written_count_ += nwrite;
-  auto& buf = stream->queue_.front();
-  buf.written += nwrite;
-  if (buf.written == buf.len) {
+  stream->unsynced_count_ += nwrite;
+  // The write may be partial, distribute the written bytes to the buffers in
+  // the order of the queue.
+  ssize_t remaining = nwrite;
+  for (auto& buf : stream->queue_) {
+    if (remaining == 0) {
+      break;
+    }
+    ssize_t count =
+        std::min(remaining, static_cast<ssize_t>(buf.len - buf.written));
+    buf.written += count;
+    remaining -= count;
+  }
+  while (!stream->queue_.empty() &&
+         stream->queue_.front().written == stream->queue_.front().len) {
+    buf_pool.Release(&stream->queue_.front());
     stream->queue_.pop_front();
   }
 
-  if (stream->queue_.size() > 0) {
-    stream->WriteNext();
+  if (stream->options_.sync_bytes > 0 &&
+      stream->unsynced_count_ >= stream->options_.sync_bytes) {
+    stream->Sync();
     return;
   }
+  stream->Continue();
+}
 
-  stream->set_writing_for_write(false);
-  if (stream->waiting_for_dispose_) {
-    uv_fs_t close_req;
-    // TODO(chengzhong.wcz): async close;
-    uv_fs_close(stream->loop_, &close_req, stream->fd_, nullptr);
-    uv_fs_req_cleanup(&close_req);
-    stream->on_end_(stream);
-    delete stream;
+void UvZeroCopyOutputFileStream::SyncCb(uv_fs_t* req) {
+  UvZeroCopyOutputFileStream* stream =
+      ContainerOf(&UvZeroCopyOutputFileStream::req_, req);
+
+  int r = req->result;
+  uv_fs_req_cleanup(req);
+  if (r < 0) {
+    ELOG("Sync error: %s", uv_strerror(r));
   }
+  stream->unsynced_count_ = 0;
+  stream->Continue();
 }
 
 void UvZeroCopyOutputFileStream::WriteNext() {
-  auto& req = queue_.front();
-  uv_buf_t buf = uv_buf_init(req.data + req.written, req.len - req.written);
+  // Coalesce all the queued buffers into one vectored write.
+  uv_buf_t bufs[MAX_WRITE_BUFS];
+  unsigned int nbufs = 0;
+  for (auto& it : queue_) {
+    if (nbufs == MAX_WRITE_BUFS) {
+      break;
+    }
+    bufs[nbufs++] = uv_buf_init(it.data + it.written, it.len - it.written);
+  }
+
+  uv_fs_write(loop_, &req_, fd_, bufs, nbufs, written_count_, WriteCb);
+}
+
+void UvZeroCopyOutputFileStream::Sync() {
+  uv_fs_fdatasync(loop_, &req_, fd_, SyncCb);
+}
+
+void UvZeroCopyOutputFileStream::Continue() {
+  if (queue_.size() > 0) {
+    WriteNext();
+    return;
+  }
+
+  set_writing_for_write(false);
+  if (waiting_for_dispose_) {
+    MaybeEnd();
+  }
+}
 
-  uv_fs_write(loop_, &req_, fd_, &buf, 1, written_count_, WriteCb);
+void UvZeroCopyOutputFileStream::MaybeEnd() {
+  if (options_.sync_bytes >= 0 && unsynced_count_ > 0) {
+    // Continue() will get back here once the data is synced.
+    Sync();
+    return;
+  }
+  uv_fs_t close_req;
+  // TODO(chengzhong.wcz): async close;
+  uv_fs_close(loop_, &close_req, fd_, nullptr);
+  uv_fs_req_cleanup(&close_req);
+
+  on_end_(this);
+  delete this;
 }
 
 UvZeroCopyOutputFileStream::UvZeroCopyOutputFileStream(uv_loop_t* loop,
                                                        int fd,
+                                                       Options options,
                                                        Callback on_end)
     : ZeroCopyOutputStream(),
       loop_(loop),
       fd_(fd),
       idle_(new uv_idle_t),
+      options_(options),
       on_end_(on_end) {
   uv_idle_init(loop, idle_);
   idle_->data = this;
@@ -210,6 +699,9 @@ UvZeroCopyOutputFileStream::~UvZeroCopyOutputFileStream() {
     uv_idle_t* idle = reinterpret_cast<uv_idle_t*>(handle);
     delete idle;
   });
+  for (auto& buf : queue_) {
+    buf_pool.Release(&buf);
+  }
 }
 
 bool UvZeroCopyOutputFileStream::Next(void** data, int* size) {
@@ -217,7 +709,7 @@ bool UvZeroCopyOutputFileStream::Next(void** data, int* size) {
   CHECK_NE(size, nullptr);
   CHECK_EQ(waiting_for_dispose_, false);
 
-  char* buf = new char[MAX_PIPE_PAGE];
+  char* buf = buf_pool.Acquire();
   queue_.emplace_back(buf, MAX_PIPE_PAGE);
   *data = buf;
   *size = MAX_PIPE_PAGE;
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <google/protobuf/io/zero_copy_stream.h>
+#include <google/protobuf/message_lite.h>
 #include <functional>
 #include <list>
 #include <memory>
@@ -11,6 +12,7 @@
 namespace aworker {
 using ZeroCopyInputStream = google::protobuf::io::ZeroCopyInputStream;
 using ZeroCopyOutputStream = google::protobuf::io::ZeroCopyOutputStream;
+using MessageLite = google::protobuf::MessageLite;
 
 struct ZeroCopyStreamBuf {
   char* data = nullptr;
@@ -69,10 +71,99 @@ class UvZeroCopyInputFileStream : public ZeroCopyInputStream {
   Callback callback_;
 };
 
-// Although it is named as a stream, it is not actually a streaming file writing
-// pattern.
+// Streaming file reading with bounded read-ahead. Chunks are read on the libuv
+// threadpool while the previous chunks are being consumed, and at most
+// `read_ahead` chunks are buffered at any time regardless of the file size.
+// `Next` never blocks the loop thread: if the next chunk has not been read yet
+// it returns false with `would_block()` set, and the consumer resumes once
+// the callback of `Wait` is invoked. Protobuf messages are parsed with
+// `ParseMessage` as the chunks are read.
+class UvStreamingZeroCopyInputFileStream : public ZeroCopyInputStream {
+ public:
+  using Callback =
+      std::function<void(std::unique_ptr<UvStreamingZeroCopyInputFileStream>)>;
+  // The file is opened asynchronously, and the callback is invoked once the
+  // first chunk is available.
+  static void Create(uv_loop_t* loop,
+                     std::string path,
+                     int read_ahead,
+                     Callback callback);
+  ~UvStreamingZeroCopyInputFileStream();
+
+  // Ownership of this buffer remains with the stream, and the buffer remains
+  // valid only until some other method of the stream is called or the stream is
+  // destroyed.
+  bool Next(const void** data, int* size) override;
+  void BackUp(int count) override;
+  bool Skip(int count) override;
+  int64_t ByteCount() const override;
+
+  // Invoke the callback on the loop thread once `Next` can make progress,
+  // immediately if it can already.
+  void Wait(std::function<void()> callback);
+  // Merge the rest of the stream into the message one top-level field at a
+  // time as the chunks are read, only the field spanning the chunks read so
+  // far is buffered. The callback is invoked with whether the message is
+  // parsed and initialized.
+  void ParseMessage(MessageLite* message, std::function<void(bool)> callback);
+
+  // Whether the last `Next` returned false because the chunk was not read yet.
+  inline bool would_block() const { return would_block_; }
+  // Negative uv error code if any read failed.
+  inline int error() const { return error_; }
+
+ private:
+  struct SharedState;
+  struct Chunk;
+  struct OpenReq;
+
+  static void OpenCb(uv_fs_t* req);
+  static void ReadWork(uv_work_t* req);
+  static void AfterReadWork(uv_work_t* req, int status);
+  UvStreamingZeroCopyInputFileStream(uv_loop_t* loop,
+                                     uv_file fd,
+                                     int read_ahead,
+                                     Callback callback);
+  void ReadAhead();
+  void OnChunkRead(Chunk* chunk);
+  bool IsReadable();
+  void ParseAvailableFields();
+  bool ParseFields(const char* data, size_t size);
+  bool MergeField(const char* data, size_t size);
+  void FinishParsing(bool success);
+
+  uv_loop_t* loop_;
+  int read_ahead_;
+  std::shared_ptr<SharedState> state_;
+  std::list<std::shared_ptr<Chunk>> chunks_;
+  std::shared_ptr<Chunk> current_;
+  int64_t fs_read_offset_ = 0;
+  int64_t byte_count_ = 0;
+  int backup_count_ = 0;
+  bool eof_ = false;
+  bool would_block_ = false;
+  int error_ = 0;
+  Callback callback_;
+  std::function<void()> readable_callback_;
+
+  MessageLite* parse_message_ = nullptr;
+  std::function<void(bool)> parse_callback_;
+  // The top-level field spanning the chunks, and its length once the field
+  // header is complete.
+  std::string pending_field_;
+  size_t pending_field_length_ = 0;
+};
+
+// Queued buffers are flushed with one vectored write per round trip.
 class UvZeroCopyOutputFileStream : public ZeroCopyOutputStream {
  public:
+  struct Options {
+    // Issue fdatasync(2) once at least `sync_bytes` bytes have been written
+    // since the last sync, and before the file is closed. Negative to never
+    // sync, 0 to only sync before the file is closed.
+    int64_t sync_bytes = -1;
+  };
+
   static void DisposeAndDelete(UvZeroCopyOutputFileStream* stream);
   using UvZeroCopyOutputFileStreamPtr =
       DeleteFnPtr<UvZeroCopyOutputFileStream, DisposeAndDelete>;
@@ -80,6 +171,10 @@ class UvZeroCopyOutputFileStream : public ZeroCopyOutputStream {
   static UvZeroCopyOutputFileStreamPtr Create(uv_loop_t* loop,
                                               std::string path,
                                               Callback on_end);
+  static UvZeroCopyOutputFileStreamPtr Create(uv_loop_t* loop,
+                                              std::string path,
+                                              Options options,
+                                              Callback on_end);
 
   // Ownership of this buffer remains with the stream, and the buffer remains
   // valid only until some other method of the stream is called or the stream is
@@ -90,9 +185,16 @@ class UvZeroCopyOutputFileStream : public ZeroCopyOutputStream {
 
  private:
   static void WriteCb(uv_fs_t* req);
+  static void SyncCb(uv_fs_t* req);
   static void IdleCb(uv_idle_t* handle);
   void WriteNext();
-  UvZeroCopyOutputFileStream(uv_loop_t* loop, int fd, Callback on_end);
+  void Sync();
+  void Continue();
+  void MaybeEnd();
+  UvZeroCopyOutputFileStream(uv_loop_t* loop,
+                             int fd,
+                             Options options,
+                             Callback on_end);
   ~UvZeroCopyOutputFileStream();
 
   void set_writing_for_write(bool);
@@ -101,7 +203,9 @@ class UvZeroCopyOutputFileStream : public ZeroCopyOutputStream {
   uv_file fd_ = -1;
   uv_fs_t req_;
   uv_idle_t* idle_;
+  Options options_;
   int64_t written_count_ = 0;
+  int64_t unsynced_count_ = 0;
   bool waiting_for_write_ = false;
   bool waiting_for_dispose_ = false;
 
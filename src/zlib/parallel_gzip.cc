@@ -0,0 +1,280 @@
+#include "parallel_gzip.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include "debug_utils.h"
+#include "util.h"
+
+namespace aworker {
+namespace zlib {
+
+using per_process::Debug;
+
+#define GZIP_HEADER_SIZE 10
+#define GZIP_TRAILER_SIZE 8
+#define GZIP_OS_UNIX 3
+#define DEFLATE_MAX_DICTIONARY_SIZE (32 * 1024)
+
+struct ParallelGzip::Block {
+  uv_work_t req;
+  ParallelGzip* owner;
+  const uint8_t* input;
+  size_t byte_length;
+  const uint8_t* dictionary;
+  size_t dictionary_length;
+  bool last;
+  ResizableBuffer out;
+  size_t out_length = 0;
+  uLong crc = 0;
+  bool ok = false;
+};
+
+struct ParallelGzip::WriteReq {
+  uv_loop_t* loop;
+  const uint8_t* input;
+  size_t byte_length;
+  int flush_mode;
+  WriteCallback callback;
+  std::vector<Block> blocks;
+  size_t next_block = 0;
+  size_t pending = 0;
+  bool failed = false;
+};
+
+namespace {
+
+void WriteLE32(uint8_t* ptr, uint32_t value) {
+  ptr[0] = value & 0xff;
+  ptr[1] = (value >> 8) & 0xff;
+  ptr[2] = (value >> 16) & 0xff;
+  ptr[3] = (value >> 24) & 0xff;
+}
+
+}  // namespace
+
+// static
+bool ParallelGzip::DeflateBlock(const ParallelGzipOptions& options,
+                                Block* block) {
+  z_stream stream;
+  stream.zalloc = Z_NULL;
+  stream.zfree = Z_NULL;
+  stream.opaque = Z_NULL;
+  // Raw deflate, the gzip header and trailer are written by ParallelGzip.
+  int ret = deflateInit2(&stream,
+                         options.level,
+                         Z_DEFLATED,
+                         -options.window_bits,
+                         options.mem_level,
+                         options.strategy);
+  if (ret != Z_OK) return false;
+
+  if (block->dictionary_length > 0) {
+    ret = deflateSetDictionary(&stream,
+                               block->dictionary,
+                               static_cast<uInt>(block->dictionary_length));
+    if (ret != Z_OK) {
+      deflateEnd(&stream);
+      return false;
+    }
+  }
+
+  stream.next_in = const_cast<Bytef*>(block->input);
+  stream.avail_in = static_cast<uInt>(block->byte_length);
+  // Reserve some room for the empty stored block of Z_SYNC_FLUSH.
+  block->out.Realloc(deflateBound(&stream, block->byte_length) + 16);
+
+  int flush = block->last ? Z_FINISH : Z_SYNC_FLUSH;
+  bool ok = false;
+  while (true) {
+    stream.next_out =
+        static_cast<Bytef*>(block->out.buffer()) + block->out_length;
+    stream.avail_out =
+        static_cast<uInt>(block->out.byte_length() - block->out_length);
+    ret = deflate(&stream, flush);
+    block->out_length = block->out.byte_length() - stream.avail_out;
+    if (ret == Z_STREAM_ERROR) break;
+    if (block->last ? ret == Z_STREAM_END
+                    : (stream.avail_in == 0 && stream.avail_out != 0)) {
+      ok = true;
+      break;
+    }
+    if (stream.avail_out == 0) {
+      block->out.Realloc(block->out.byte_length() * 2);
+    }
+  }
+  deflateEnd(&stream);
+
+  block->crc = crc32(crc32(0L, Z_NULL, 0),
+                     block->input,
+                     static_cast<uInt>(block->byte_length));
+  return ok;
+}
+
+ParallelGzip::ParallelGzip(const ParallelGzipOptions& options)
+    : _options(options), _crc(crc32(0L, Z_NULL, 0)) {
+  CHECK_GT(_options.block_size, 0);
+  CHECK_GT(_options.threads, 0);
+}
+
+ParallelGzip::~ParallelGzip() {
+  // The owner is kept alive while a write is in flight.
+  CHECK_NULL(_write);
+}
+
+void ParallelGzip::Write(uv_loop_t* loop,
+                         const uint8_t* input,
+                         size_t byte_length,
+                         int flush_mode,
+                         WriteCallback callback) {
+  CHECK(!_finished);
+  CHECK_NULL(_write);
+  bool finish = flush_mode == Z_FINISH;
+
+  size_t block_count =
+      (byte_length + _options.block_size - 1) / _options.block_size;
+  // The final deflate block is required even if there is no more input.
+  if (block_count == 0 && finish) block_count = 1;
+  CHECK_GT(block_count, 0);
+
+  _write = std::make_unique<WriteReq>();
+  WriteReq* write = _write.get();
+  write->loop = loop;
+  write->input = input;
+  write->byte_length = byte_length;
+  write->flush_mode = flush_mode;
+  write->callback = std::move(callback);
+  write->blocks = std::vector<Block>(block_count);
+  for (size_t idx = 0; idx < block_count; idx++) {
+    Block& block = write->blocks[idx];
+    size_t offset = idx * _options.block_size;
+    block.owner = this;
+    block.input = input + offset;
+    block.byte_length = std::min(_options.block_size, byte_length - offset);
+    block.last = finish && idx == block_count - 1;
+    if (offset == 0) {
+      block.dictionary = _dictionary.data();
+      block.dictionary_length = _dictionary.size();
+    } else {
+      block.dictionary_length =
+          std::min<size_t>(offset, DEFLATE_MAX_DICTIONARY_SIZE);
+      block.dictionary = block.input - block.dictionary_length;
+    }
+  }
+
+  QueueBlocks();
+}
+
+void ParallelGzip::QueueBlocks() {
+  WriteReq* write = _write.get();
+  while (!write->failed && write->pending < _options.threads &&
+         write->next_block < write->blocks.size()) {
+    Block& block = write->blocks[write->next_block++];
+    CHECK_EQ(
+        uv_queue_work(write->loop, &block.req, OnBlockWork, OnBlockWorkDone),
+        0);
+    write->pending++;
+  }
+  if (write->pending == 0) {
+    FinishWrite();
+  }
+}
+
+// static
+void ParallelGzip::OnBlockWork(uv_work_t* req) {
+  Block* block = ContainerOf(&Block::req, req);
+  block->ok = DeflateBlock(block->owner->_options, block);
+}
+
+// static
+void ParallelGzip::OnBlockWorkDone(uv_work_t* req, int status) {
+  Block* block = ContainerOf(&Block::req, req);
+  ParallelGzip* self = block->owner;
+  WriteReq* write = self->_write.get();
+  write->pending--;
+  if (status == UV_ECANCELED || !block->ok) {
+    write->failed = true;
+  }
+  self->QueueBlocks();
+}
+
+void ParallelGzip::FinishWrite() {
+  std::unique_ptr<WriteReq> write = std::move(_write);
+  Debug(DebugCategory::ZLIB,
+        "[trace] parallel gzip with %zu blocks on %zu threads, failed: %d\n",
+        write->blocks.size(),
+        std::min(_options.threads, write->blocks.size()),
+        write->failed);
+
+  ResizableBuffer out;
+  if (!write->failed) {
+    Assemble(write.get(), &out);
+  }
+  // The callback may release the owner of this compressor.
+  write->callback(!write->failed, std::move(out));
+}
+
+void ParallelGzip::Assemble(WriteReq* write, ResizableBuffer* out) {
+  const std::vector<Block>& blocks = write->blocks;
+  const uint8_t* input = write->input;
+  size_t byte_length = write->byte_length;
+  int flush_mode = write->flush_mode;
+  bool finish = flush_mode == Z_FINISH;
+
+  size_t total = out->byte_length();
+  size_t offset = total;
+  if (!_header_written) total += GZIP_HEADER_SIZE;
+  for (const Block& block : blocks) {
+    total += block.out_length;
+  }
+  if (finish) total += GZIP_TRAILER_SIZE;
+  out->Realloc(total);
+  uint8_t* ptr = static_cast<uint8_t*>(out->buffer()) + offset;
+
+  if (!_header_written) {
+    // The same header as deflate() would write without a gz_header.
+    uint8_t xfl = 0;
+    if (_options.level == 9) {
+      xfl = 2;
+    } else if (_options.strategy >= Z_HUFFMAN_ONLY || _options.level < 2) {
+      xfl = 4;
+    }
+    const uint8_t header[GZIP_HEADER_SIZE] = {
+        0x1f, 0x8b, Z_DEFLATED, 0, 0, 0, 0, 0, xfl, GZIP_OS_UNIX};
+    memcpy(ptr, header, GZIP_HEADER_SIZE);
+    ptr += GZIP_HEADER_SIZE;
+    _header_written = true;
+  }
+
+  for (const Block& block : blocks) {
+    memcpy(ptr, block.out.buffer(), block.out_length);
+    ptr += block.out_length;
+    _crc = crc32_combine(
+        _crc, block.crc, static_cast<z_off_t>(block.byte_length));
+  }
+  _total_in += byte_length;
+
+  if (finish) {
+    WriteLE32(ptr, static_cast<uint32_t>(_crc));
+    WriteLE32(ptr + 4, static_cast<uint32_t>(_total_in));
+    _finished = true;
+    _dictionary.clear();
+    return;
+  }
+
+  if (flush_mode == Z_FULL_FLUSH) {
+    _dictionary.clear();
+  } else if (byte_length >= DEFLATE_MAX_DICTIONARY_SIZE) {
+    _dictionary.assign(input + byte_length - DEFLATE_MAX_DICTIONARY_SIZE,
+                       input + byte_length);
+  } else {
+    _dictionary.insert(_dictionary.end(), input, input + byte_length);
+    if (_dictionary.size() > DEFLATE_MAX_DICTIONARY_SIZE) {
+      _dictionary.erase(_dictionary.begin(),
+                        _dictionary.end() - DEFLATE_MAX_DICTIONARY_SIZE);
+    }
+  }
+}
+
+}  // namespace zlib
+}  // namespace aworker
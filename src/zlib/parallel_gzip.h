@@ -0,0 +1,84 @@
+#ifndef SRC_ZLIB_PARALLEL_GZIP_H_
+#define SRC_ZLIB_PARALLEL_GZIP_H_
+
+extern "C" {
+#include <zlib.h>
+}
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <vector>
+
+#include "utils/resizable_buffer.h"
+#include "uv.h"
+
+namespace aworker {
+namespace zlib {
+
+struct ParallelGzipOptions {
+  int level;
+  int window_bits;
+  int mem_level;
+  int strategy;
+  size_t block_size;
+  size_t threads;
+};
+
+/**
+ * Produces a standard gzip member the pigz way: each written chunk is split
+ * into blocks which are deflated concurrently, each primed with the preceding
+ * 32K of input as dictionary and terminated with Z_SYNC_FLUSH so that the raw
+ * deflate streams can be concatenated. The CRC-32 of the blocks are merged
+ * with `crc32_combine`.
+ *
+ * The blocks are deflated on the libuv thread pool, at most `options.threads`
+ * of them at a time, and assembled on the loop thread.
+ */
+class ParallelGzip {
+ public:
+  using WriteCallback = std::function<void(bool ok, ResizableBuffer out)>;
+
+  explicit ParallelGzip(const ParallelGzipOptions& options);
+  ~ParallelGzip();
+
+  /**
+   * Compresses `input` and calls `callback` on the loop thread with the
+   * output, the gzip header is written before the first chunk and the trailer
+   * after the `finish` chunk. `input` must be kept alive until the callback,
+   * and only one write can be in flight at a time.
+   */
+  void Write(uv_loop_t* loop,
+             const uint8_t* input,
+             size_t byte_length,
+             int flush_mode,
+             WriteCallback callback);
+
+  inline bool finished() const { return _finished; }
+
+ private:
+  struct Block;
+  struct WriteReq;
+
+  static bool DeflateBlock(const ParallelGzipOptions& options, Block* block);
+  static void OnBlockWork(uv_work_t* req);
+  static void OnBlockWorkDone(uv_work_t* req, int status);
+  void QueueBlocks();
+  void FinishWrite();
+  void Assemble(WriteReq* write, ResizableBuffer* out);
+
+  ParallelGzipOptions _options;
+  std::unique_ptr<WriteReq> _write;
+  bool _header_written = false;
+  bool _finished = false;
+  uLong _crc;
+  uint64_t _total_in = 0;
+  // Tail of the previous input, used as dictionary of the next block.
+  std::vector<uint8_t> _dictionary;
+};
+
+}  // namespace zlib
+}  // namespace aworker
+
+#endif  // SRC_ZLIB_PARALLEL_GZIP_H_
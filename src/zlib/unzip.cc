@@ -41,31 +41,37 @@ UnzipWrapper::~UnzipWrapper() {
 }
 
 void UnzipWrapper::DoZlibEnd() {
-  int ret = inflateEnd(&_stream);
-  Debug(DebugCategory::ZLIB, "[call] inflateEnd(&_stream): %d\n", ret);
-  CHECK(ret == Z_OK || ret == Z_DATA_ERROR);
+  Debug(DebugCategory::ZLIB, "[call] UnzipWrapper::DoZlibEnd()\n");
+  ReleaseStream();
 }
 
 bool UnzipWrapper::Init() {
-  _stream.zalloc = Z_NULL;
-  _stream.zfree = Z_NULL;
-  _stream.opaque = Z_NULL;
-  _stream.avail_in = 0;
-  _stream.next_in = Z_NULL;
-
   int window_bits = _window_bits;
   if (_type == static_cast<int>(UnzipType::GUNZIP)) {
     window_bits += 16;
   }
 
-  int ret = inflateInit2(&_stream, window_bits);
   _inited = true;
+  ZlibStreamKey key{ZlibStreamKey::Mode::kInflate, 0, window_bits, 0, 0};
+  if (AcquireStream(key)) {
+    Debug(DebugCategory::ZLIB, "[trace] inflate stream reused from pool\n");
+    return true;
+  }
+
+  _stream->zalloc = Z_NULL;
+  _stream->zfree = Z_NULL;
+  _stream->opaque = Z_NULL;
+  _stream->avail_in = 0;
+  _stream->next_in = Z_NULL;
+
+  int ret = inflateInit2(_stream.get(), window_bits);
 
   Debug(DebugCategory::ZLIB,
-        "[call] inflateInit2(&_stream, _window_bits: %d): %d\n",
+        "[call] inflateInit2(_stream, _window_bits: %d): %d\n",
         _window_bits,
         ret);
 
+  _stream_ready = ret == Z_OK;
   return ret == Z_OK;
 }
 
@@ -178,7 +184,7 @@ MaybeLocal<Value> UnzipWrapper::Push(Local<Object> this_object,
         return MaybeLocal<Value>();
       }
 
-      ReleasedResizableBuffer managed = task->out()->Release();
+      ReleasedResizableBuffer managed = task->ReleaseOutput();
       backing_store_1 = ArrayBuffer::NewBackingStore(
           managed.buff,
           managed.byte_length,
@@ -200,7 +206,7 @@ MaybeLocal<Value> UnzipWrapper::Push(Local<Object> this_object,
       return MaybeLocal<Value>();
     }
 
-    ReleasedResizableBuffer managed = task->out()->Release();
+    ReleasedResizableBuffer managed = task->ReleaseOutput();
     backing_store_2 = ArrayBuffer::NewBackingStore(
         managed.buff,
         managed.byte_length,
@@ -227,7 +233,7 @@ MaybeLocal<Value> UnzipWrapper::Push(Local<Object> this_object,
 
   if (!_running) {
     _running = true;
-    immortal->macro_task_queue()->Enqueue(std::move(_task_queue.front()));
+    Schedule(std::move(_task_queue.front()));
     _task_queue.pop();
   }
 
@@ -1,10 +1,32 @@
 #include "unzip_task.h"
+#include <algorithm>
 #include "debug_utils.h"
 #include "zlib_wrapper.h"
 
 namespace aworker {
 namespace zlib {
 
+#define GZIP_MIN_MEMBER_SIZE 18
+// Deflate can not compress better than 1032:1.
+#define DEFLATE_MAX_RATIO 1032
+#define UNZIP_MAX_RESERVED_OUTPUT_SIZE (16 * 1024 * 1024)
+
+size_t ExpectedGzipOutputLength(const uint8_t* data, size_t byte_length) {
+  if (byte_length < GZIP_MIN_MEMBER_SIZE || data[0] != 0x1f ||
+      data[1] != 0x8b) {
+    return 0;
+  }
+  const uint8_t* trailer = data + byte_length - 4;
+  size_t isize = static_cast<size_t>(trailer[0]) |
+                 (static_cast<size_t>(trailer[1]) << 8) |
+                 (static_cast<size_t>(trailer[2]) << 16) |
+                 (static_cast<size_t>(trailer[3]) << 24);
+  if (isize > byte_length * DEFLATE_MAX_RATIO) {
+    return 0;
+  }
+  return std::min(isize, static_cast<size_t>(UNZIP_MAX_RESERVED_OUTPUT_SIZE));
+}
+
 /**
  * Reference for UnzipTask::Tick():
  *  > https://zlib.net/zlib_how.html
@@ -65,22 +87,28 @@ namespace zlib {
  * }
  */
 void UnzipTask::OnWorkTick() {
+  EnsureParentSnapshot();
   // if error occurred already, or finished already, do not tick any more.
-  if (_parent->finished()) {
+  if (_parent_finished) {
     Fail("Uncompression already done.");
     return;
-  } else if (_parent->errored()) {
+  } else if (_parent_errored) {
     Fail("Uncompression already failed.");
     return;
   }
 
-  if (!_prepared) Prepare();
-
-  ZlibStreamPtr stream = _parent->stream();
-  ResizableBuffer* chunk_buffer = _parent->chunk_buffer();
+  ZlibStreamPtr stream = _stream;
+  if (!_prepared) {
+    // The whole gzip member is available up front, size the output with the
+    // ISIZE of its trailer so that inflate() can finish in one call.
+    if (_flush_mode == Z_FINISH && stream->total_in == 0) {
+      ReserveOutput(ExpectedGzipOutputLength(
+          static_cast<const uint8_t*>(data()), byte_length()));
+    }
+    Prepare();
+  }
 
-  stream->avail_out = chunk_buffer->byte_length();
-  stream->next_out = static_cast<unsigned char*>(chunk_buffer->buffer());
+  PrepareOutput(stream);
 
   per_process::Debug(DebugCategory::ZLIB,
                      "[trace] up to do unzip task with avail_in: %d, "
@@ -95,6 +123,14 @@ void UnzipTask::OnWorkTick() {
                      _flush_mode,
                      status);
 
+  // With Z_FINISH, inflate() reports Z_BUF_ERROR if the output buffer is not
+  // large enough to finish the stream, e.g. the reserved output was sized with
+  // the ISIZE of the last of several concatenated members, or an ISIZE
+  // wrapped around 2^32. Continue with the next chunk.
+  if (status == Z_BUF_ERROR && stream->avail_out == 0) {
+    status = Z_OK;
+  }
+
   char error_msg[128] = {0};
   switch (status) {
     case Z_STREAM_ERROR:
@@ -132,7 +168,7 @@ void UnzipTask::OnWorkTick() {
   }
 
   // The output of inflate() is handled identically to that of deflate().
-  ConcatChunkToResult(stream, *chunk_buffer);
+  CommitOutput(stream);
 
   // When inflate() reports that it has reached the end of the input zlib
   // stream, has completed the decompression and integrity check, and has
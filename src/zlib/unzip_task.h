@@ -6,6 +6,11 @@
 namespace aworker {
 namespace zlib {
 
+// Returns the ISIZE recorded in the trailer if `data` looks like a complete
+// gzip member, or 0 if the output length is unknown. For concatenated members
+// the trailer is the one of the last member, so the result is only a hint.
+size_t ExpectedGzipOutputLength(const uint8_t* data, size_t byte_length);
+
 class UnzipTask : public ZlibTask {
  public:
   UnzipTask(Immortal* immortal,
@@ -1,4 +1,5 @@
 #include "zip.h"
+#include "command_parser.h"
 #include "debug_utils.h"
 #include "error_handling.h"
 #include "zip_task.h"
@@ -21,6 +22,9 @@ using v8::Value;
 
 const WrapperTypeInfo ZipWrapper::wrapper_type_info_{"zip_wrapper"};
 
+#define PARALLEL_GZIP_MIN_BYTE_LENGTH (1024 * 1024)
+#define PARALLEL_GZIP_BLOCK_SIZE (128 * 1024)
+
 ZipWrapper::ZipWrapper(Immortal* immortal,
                        Local<Object> handle,
                        ZipType type,
@@ -32,7 +36,8 @@ ZipWrapper::ZipWrapper(Immortal* immortal,
                   static_cast<int>(type),
                   is_sync,
                   window_bits,
-                  options) {
+                  options),
+      _parallel_threads(0) {
   CHECK(options->IsObject() && !options.IsEmpty());
   Isolate* isolate = immortal->isolate();
   Local<Context> context = immortal->context();
@@ -59,6 +64,12 @@ ZipWrapper::ZipWrapper(Immortal* immortal,
   SET_PROPERTY(strategy);
 
 #undef SET_PROPERTY
+
+  // Synchronous streams compress on the calling thread anyway.
+  if (type == ZipType::GZIP && !is_sync) {
+    int threads = immortal->commandline_parser()->zlib_parallel_gzip_threads();
+    _parallel_threads = threads > 0 ? threads : 0;
+  }
 }
 
 ZipWrapper::~ZipWrapper() {
@@ -75,39 +86,70 @@ ZipWrapper::~ZipWrapper() {
 }
 
 void ZipWrapper::DoZlibEnd() {
-  int ret = deflateEnd(&_stream);
-  Debug(DebugCategory::ZLIB, "[call] deflateEnd(&_stream): %d\n", ret);
-  CHECK(ret == Z_OK || ret == Z_DATA_ERROR);
+  Debug(DebugCategory::ZLIB, "[call] ZipWrapper::DoZlibEnd()\n");
+  ReleaseStream();
 }
 
 bool ZipWrapper::Init() {
-  _stream.zalloc = Z_NULL;
-  _stream.zfree = Z_NULL;
-  _stream.opaque = Z_NULL;
-  _stream.avail_in = 0;
-  _stream.next_in = Z_NULL;
-
   int window_bits = _window_bits;
   if (_type == static_cast<int>(ZipType::GZIP)) {
     window_bits += 16;
   }
 
+  _inited = true;
+  ZlibStreamKey key{ZlibStreamKey::Mode::kDeflate,
+                    _level,
+                    window_bits,
+                    _mem_level,
+                    _strategy};
+  if (AcquireStream(key)) {
+    Debug(DebugCategory::ZLIB, "[trace] deflate stream reused from pool\n");
+    return true;
+  }
+
+  _stream->zalloc = Z_NULL;
+  _stream->zfree = Z_NULL;
+  _stream->opaque = Z_NULL;
+  _stream->avail_in = 0;
+  _stream->next_in = Z_NULL;
+
   int ret = deflateInit2(
-      &_stream, _level, Z_DEFLATED, window_bits, _mem_level, _strategy);
+      _stream.get(), _level, Z_DEFLATED, window_bits, _mem_level, _strategy);
 
   Debug(
       DebugCategory::ZLIB,
-      "[call] deflateInit2(&_stream, _level: %d, Z_DEFLATED, _window_bits: %d, "
+      "[call] deflateInit2(_stream, _level: %d, Z_DEFLATED, _window_bits: %d, "
       "_mem_level: %d, _strategy: %d): %d\n",
       _level,
       _window_bits,
       _mem_level,
       _strategy,
       ret);
-  _inited = true;
+  _stream_ready = ret == Z_OK;
   return ret == Z_OK;
 }
 
+ParallelGzip* ZipWrapper::MaybeParallelGzip(size_t byte_length) {
+  if (_parallel_gzip) return _parallel_gzip.get();
+  // The stream is returned to the pool once the wrapper ended, the task is
+  // failed without touching it.
+  if (_ended || _stream == nullptr) return nullptr;
+  // Nothing must have been written to the stream, and the raw deflate window
+  // can not be smaller than 512 bytes.
+  if (_parallel_threads <= 1 || byte_length < PARALLEL_GZIP_MIN_BYTE_LENGTH ||
+      _stream->total_in != 0 || _stream->total_out != 0 || _window_bits < 9) {
+    return nullptr;
+  }
+  ParallelGzipOptions options{_level,
+                              _window_bits,
+                              _mem_level,
+                              _strategy,
+                              PARALLEL_GZIP_BLOCK_SIZE,
+                              _parallel_threads};
+  _parallel_gzip = std::make_unique<ParallelGzip>(options);
+  return _parallel_gzip.get();
+}
+
 MaybeLocal<Value> ZipWrapper::Push(Local<Object> this_object,
                                    Local<ArrayBuffer> array_buffer,
                                    size_t array_buffer_offset,
@@ -146,7 +188,7 @@ MaybeLocal<Value> ZipWrapper::Push(Local<Object> this_object,
       return MaybeLocal<Value>();
     }
 
-    ReleasedResizableBuffer managed = task->out()->Release();
+    ReleasedResizableBuffer managed = task->ReleaseOutput();
     backing_store = ArrayBuffer::NewBackingStore(
         managed.buff,
         managed.byte_length,
@@ -162,7 +204,7 @@ MaybeLocal<Value> ZipWrapper::Push(Local<Object> this_object,
 
   if (!_running) {
     _running = true;
-    immortal->macro_task_queue()->Enqueue(std::move(_task_queue.front()));
+    Schedule(std::move(_task_queue.front()));
     _task_queue.pop();
   }
 
@@ -1,6 +1,9 @@
 #ifndef SRC_ZLIB_ZIP_H_
 #define SRC_ZLIB_ZIP_H_
 
+#include <memory>
+
+#include "parallel_gzip.h"
 #include "zlib_wrapper.h"
 
 namespace aworker {
@@ -34,10 +37,20 @@ class ZipWrapper : public ZlibWrapper {
                                  v8::Local<v8::Function> callback) override;
   void DoZlibEnd() override;
 
+  /**
+   * Returns the parallel compressor if the task input should be compressed
+   * with it. The stream switches to `ParallelGzip` if its first input is large
+   * enough, and stays with it till the end.
+   */
+  ParallelGzip* MaybeParallelGzip(size_t byte_length);
+  bool parallel() override { return _parallel_gzip != nullptr; }
+
  private:
   int _level;
   int _mem_level;
   int _strategy;
+  size_t _parallel_threads;
+  std::unique_ptr<ParallelGzip> _parallel_gzip;
 };
 
 }  // namespace zlib
@@ -1,6 +1,6 @@
 #include "zip_task.h"
 #include "debug_utils.h"
-#include "zlib_wrapper.h"
+#include "zip.h"
 
 namespace aworker {
 namespace zlib {
@@ -56,23 +56,59 @@ namespace zlib {
  *     return Z_OK;
  * }
  */
+void ZipTask::SnapshotParent() {
+  ZlibTask::SnapshotParent();
+  _parallel_gzip =
+      static_cast<ZipWrapper*>(_parent)->MaybeParallelGzip(byte_length());
+}
+
+bool ZipTask::IsAsyncWork() {
+  // The ticks fail the task if the stream is not writable any more.
+  return _parallel_gzip != nullptr && !_parent_finished && !_parent_errored;
+}
+
+void ZipTask::StartAsyncWork() {
+  _parallel_gzip->Write(immortal()->event_loop(),
+                        static_cast<uint8_t*>(data()),
+                        byte_length(),
+                        _flush_mode,
+                        [this](bool ok, ResizableBuffer out) {
+                          if (ok) {
+                            AppendOutput(std::move(out));
+                            Done(_parallel_gzip->finished());
+                          } else {
+                            Fail("parallel gzip failed.");
+                          }
+                          AsyncWorkDone();
+                        });
+}
+
 void ZipTask::OnWorkTick() {
+  EnsureParentSnapshot();
   // if error occurred already, or finished already, do not tick any more.
-  if (_parent->finished()) {
+  if (_parent_finished) {
     Fail("Compression already done.");
     return;
-  } else if (_parent->errored()) {
+  } else if (_parent_errored) {
     Fail("Compression already failed.");
     return;
   }
 
-  if (!_prepared) Prepare();
+  // Parallel gzip tasks are not ticked, see `StartAsyncWork`.
+  CHECK_NULL(_parallel_gzip);
 
-  ZlibStreamPtr stream = _parent->stream();
-  ResizableBuffer* chunk_buffer = _parent->chunk_buffer();
+  ZlibStreamPtr stream = _stream;
+  if (!_prepared) {
+    // The whole input is available up front, deflate() can finish the stream
+    // in one call with an output buffer of deflateBound().
+    if (_flush_mode == Z_FINISH && stream->total_in == 0 &&
+        stream->total_out == 0) {
+      ReserveOutput(deflateBound(stream, byte_length()));
+    }
+    Prepare();
+  }
 
-  stream->avail_out = chunk_buffer->byte_length();
-  stream->next_out = static_cast<unsigned char*>(chunk_buffer->buffer());
+  PrepareOutput(stream);
 
   per_process::Debug(
       DebugCategory::ZLIB,
@@ -122,7 +158,7 @@ void ZipTask::OnWorkTick() {
     return;
   }
 
-  ConcatChunkToResult(stream, *chunk_buffer);
+  CommitOutput(stream);
 
   if (status == Z_STREAM_END && _flush_mode == Z_FINISH) {
     Done(true /** all done */);
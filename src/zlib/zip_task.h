@@ -1,6 +1,7 @@
 #ifndef SRC_ZLIB_ZIP_TASK_H_
 #define SRC_ZLIB_ZIP_TASK_H_
 
+#include "parallel_gzip.h"
 #include "zlib_task.h"
 
 namespace aworker {
@@ -23,7 +24,15 @@ class ZipTask : public ZlibTask {
                  array_buffer_length,
                  flush_mode) {}
 
+  void SnapshotParent() override;
   void OnWorkTick() override;
+  bool IsAsyncWork() override;
+
+ protected:
+  void StartAsyncWork() override;
+
+ private:
+  ParallelGzip* _parallel_gzip = nullptr;
 };
 
 }  // namespace zlib
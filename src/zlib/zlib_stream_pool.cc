@@ -0,0 +1,93 @@
+#include "zlib_stream_pool.h"
+#include "debug_utils.h"
+
+namespace aworker {
+namespace zlib {
+
+using per_process::Debug;
+
+ZlibStreamPool::ZlibStreamPool(size_t capacity) : _capacity(capacity) {}
+
+ZlibStreamPool::~ZlibStreamPool() {
+  Trim();
+}
+
+std::unique_ptr<z_stream> ZlibStreamPool::Acquire(const ZlibStreamKey& key) {
+  auto it = _streams.find(key);
+  if (it == _streams.end() || it->second.empty()) {
+    return nullptr;
+  }
+  std::unique_ptr<z_stream> stream = std::move(it->second.back());
+  it->second.pop_back();
+  _size--;
+  Debug(DebugCategory::ZLIB,
+        "[trace] ZlibStreamPool::Acquire(), idle streams: %zu\n",
+        _size);
+  return stream;
+}
+
+void ZlibStreamPool::Release(const ZlibStreamKey& key,
+                             std::unique_ptr<z_stream> stream) {
+  if (stream == nullptr) return;
+  if (_size >= _capacity) {
+    End(key, stream.get());
+    return;
+  }
+
+  int ret = key.mode == ZlibStreamKey::Mode::kDeflate
+                ? deflateReset(stream.get())
+                : inflateReset(stream.get());
+  if (ret != Z_OK) {
+    End(key, stream.get());
+    return;
+  }
+  stream->next_in = Z_NULL;
+  stream->avail_in = 0;
+  stream->next_out = Z_NULL;
+  stream->avail_out = 0;
+
+  _streams[key].push_back(std::move(stream));
+  _size++;
+  Debug(DebugCategory::ZLIB,
+        "[trace] ZlibStreamPool::Release(), idle streams: %zu\n",
+        _size);
+}
+
+void ZlibStreamPool::Trim() {
+  for (auto& it : _streams) {
+    for (auto& stream : it.second) {
+      End(it.first, stream.get());
+    }
+  }
+  _streams.clear();
+  _size = 0;
+}
+
+// static
+void ZlibStreamPool::OnGCEpilogue(v8::Isolate* isolate,
+                                  v8::GCType type,
+                                  v8::GCCallbackFlags flags,
+                                  void* data) {
+  // Isolate::LowMemoryNotification and MemoryPressureNotification collect all
+  // available garbage.
+  if ((flags & v8::kGCCallbackFlagCollectAllAvailableGarbage) == 0) {
+    return;
+  }
+  ZlibStreamPool* pool = static_cast<ZlibStreamPool*>(data);
+  Debug(DebugCategory::ZLIB,
+        "[trace] ZlibStreamPool trimmed on memory pressure, idle streams: "
+        "%zu\n",
+        pool->size());
+  pool->Trim();
+}
+
+// static
+void ZlibStreamPool::End(const ZlibStreamKey& key, z_stream* stream) {
+  int ret = key.mode == ZlibStreamKey::Mode::kDeflate ? deflateEnd(stream)
+                                                      : inflateEnd(stream);
+  Debug(DebugCategory::ZLIB, "[call] ZlibStreamPool::End(): %d\n", ret);
+  CHECK(ret == Z_OK || ret == Z_DATA_ERROR);
+}
+
+}  // namespace zlib
+}  // namespace aworker
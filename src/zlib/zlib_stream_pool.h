@@ -0,0 +1,85 @@
+#ifndef SRC_ZLIB_ZLIB_STREAM_POOL_H_
+#define SRC_ZLIB_ZLIB_STREAM_POOL_H_
+
+extern "C" {
+#include <zlib.h>
+}
+
+#include <map>
+#include <memory>
+#include <tuple>
+#include <vector>
+
+#include "v8.h"
+
+namespace aworker {
+namespace zlib {
+
+struct ZlibStreamKey {
+  enum class Mode { kDeflate, kInflate };
+
+  Mode mode;
+  int level;
+  // The window bits passed to deflateInit2 / inflateInit2, including the
+  // offset of the gzip wrapper.
+  int window_bits;
+  int mem_level;
+  int strategy;
+
+  bool operator<(const ZlibStreamKey& other) const {
+    return std::tie(mode, level, window_bits, mem_level, strategy) <
+           std::tie(other.mode,
+                    other.level,
+                    other.window_bits,
+                    other.mem_level,
+                    other.strategy);
+  }
+};
+
+/**
+ * Per-isolate pool of initialized `z_stream`s. Streams are reset with
+ * `deflateReset` / `inflateReset` on release, so that the window and hash
+ * state allocated by `deflateInit2` / `inflateInit2` can be reused by the
+ * next stream with the same parameters.
+ *
+ * The pool keeps at most `capacity` idle streams and is trimmed on memory
+ * pressure. It is not thread-safe and should only be used on the loop thread.
+ */
+class ZlibStreamPool {
+ public:
+  explicit ZlibStreamPool(size_t capacity);
+  ~ZlibStreamPool();
+
+  /**
+   * Returns an idle stream of the key, or nullptr if there is none.
+   */
+  std::unique_ptr<z_stream> Acquire(const ZlibStreamKey& key);
+  /**
+   * Resets the stream and keeps it for reuse, or ends it if the pool is full.
+   */
+  void Release(const ZlibStreamKey& key, std::unique_ptr<z_stream> stream);
+  /**
+   * Ends all idle streams.
+   */
+  void Trim();
+
+  inline size_t size() const { return _size; }
+  inline size_t capacity() const { return _capacity; }
+
+  static void OnGCEpilogue(v8::Isolate* isolate,
+                           v8::GCType type,
+                           v8::GCCallbackFlags flags,
+                           void* data);
+
+ private:
+  static void End(const ZlibStreamKey& key, z_stream* stream);
+
+  size_t _capacity;
+  size_t _size = 0;
+  std::map<ZlibStreamKey, std::vector<std::unique_ptr<z_stream>>> _streams;
+};
+
+}  // namespace zlib
+}  // namespace aworker
+
+#endif  // SRC_ZLIB_ZLIB_STREAM_POOL_H_
@@ -0,0 +1,305 @@
+#include "zlib_sync.h"
+#include <algorithm>
+#include <climits>
+#include <cstdlib>
+#include "debug_utils.h"
+#include "error_handling.h"
+#include "unzip.h"
+#include "unzip_task.h"
+#include "util.h"
+#include "zip.h"
+
+namespace aworker {
+namespace zlib {
+
+using per_process::Debug;
+using v8::ArrayBuffer;
+using v8::BackingStore;
+using v8::Context;
+using v8::HandleScope;
+using v8::Int32;
+using v8::Isolate;
+using v8::Local;
+using v8::Object;
+using v8::Value;
+
+#define GZIP_HEADER_ID1 0x1f
+#define GZIP_HEADER_ID2 0x8b
+#define ZLIB_SYNC_MIN_OUTPUT_SIZE (64 * 1024)
+
+namespace {
+
+/**
+ * Owns the output of a one-shot zlib call until it is handed over to an
+ * `ArrayBuffer`.
+ */
+class SyncOutput {
+ public:
+  ~SyncOutput() { free(_data); }
+
+  bool Reserve(size_t capacity) {
+    void* data = realloc(_data, capacity);
+    if (data == nullptr) return false;
+    _data = static_cast<uint8_t*>(data);
+    _capacity = capacity;
+    return true;
+  }
+
+  void Prepare(z_stream* stream) {
+    stream->next_out = _data + _byte_length;
+    stream->avail_out = static_cast<uInt>(
+        std::min(_capacity - _byte_length, static_cast<size_t>(UINT_MAX)));
+  }
+
+  void Commit(z_stream* stream) {
+    _byte_length = stream->next_out - _data;
+  }
+
+  inline bool full() { return _byte_length == _capacity; }
+  inline size_t capacity() { return _capacity; }
+
+  Local<ArrayBuffer> Release(Isolate* isolate) {
+    if (_byte_length == 0) {
+      return ArrayBuffer::New(isolate, 0);
+    }
+    std::unique_ptr<BackingStore> backing_store = ArrayBuffer::NewBackingStore(
+        _data,
+        _byte_length,
+        [](void* data, size_t length, void* deleter_data) {
+          free(deleter_data);
+        },
+        _data);
+    _data = nullptr;
+    _capacity = 0;
+    _byte_length = 0;
+    return ArrayBuffer::New(isolate, std::move(backing_store));
+  }
+
+ private:
+  uint8_t* _data = nullptr;
+  size_t _capacity = 0;
+  size_t _byte_length = 0;
+};
+
+int32_t GetInt32Option(Immortal* immortal,
+                       Local<Object> options,
+                       Local<v8::String> name) {
+  Local<Context> context = immortal->context();
+  Local<Value> value = options->Get(context, name).ToLocalChecked();
+  CHECK(value->IsInt32());
+  return value.As<Int32>()->Value();
+}
+
+std::unique_ptr<z_stream> AcquireDeflateStream(Immortal* immortal,
+                                               const ZlibStreamKey& key) {
+  std::unique_ptr<z_stream> stream =
+      immortal->zlib_stream_pool()->Acquire(key);
+  if (stream != nullptr) {
+    Debug(DebugCategory::ZLIB, "[trace] deflate stream reused from pool\n");
+    return stream;
+  }
+
+  // Value-initialized, i.e. zalloc, zfree and opaque are Z_NULL.
+  stream = std::make_unique<z_stream>();
+  int ret = deflateInit2(stream.get(),
+                         key.level,
+                         Z_DEFLATED,
+                         key.window_bits,
+                         key.mem_level,
+                         key.strategy);
+  Debug(DebugCategory::ZLIB, "[call] deflateInit2() in sync: %d\n", ret);
+  if (ret != Z_OK) return nullptr;
+  return stream;
+}
+
+std::unique_ptr<z_stream> AcquireInflateStream(Immortal* immortal,
+                                               const ZlibStreamKey& key) {
+  std::unique_ptr<z_stream> stream =
+      immortal->zlib_stream_pool()->Acquire(key);
+  if (stream != nullptr) {
+    Debug(DebugCategory::ZLIB, "[trace] inflate stream reused from pool\n");
+    return stream;
+  }
+
+  // Value-initialized, i.e. zalloc, zfree and opaque are Z_NULL.
+  stream = std::make_unique<z_stream>();
+  int ret = inflateInit2(stream.get(), key.window_bits);
+  Debug(DebugCategory::ZLIB, "[call] inflateInit2() in sync: %d\n", ret);
+  if (ret != Z_OK) return nullptr;
+  return stream;
+}
+
+}  // namespace
+
+AWORKER_METHOD(CompressSync) {
+  Immortal* immortal = Immortal::GetCurrent(info);
+  Isolate* isolate = immortal->isolate();
+  HandleScope scope(isolate);
+
+  int32_t type = info[0].As<Int32>()->Value();
+  if (type < 0 || type >= ZipWrapper::TypeEnumMax()) {
+    ThrowException(isolate,
+                   "Unsupported compression type.",
+                   ExceptionType::kRangeError);
+    return;
+  }
+  CHECK(info[1]->IsArrayBuffer());
+  Local<ArrayBuffer> array_buffer = info[1].As<ArrayBuffer>();
+  size_t offset = info[2].As<Int32>()->Value();
+  size_t length = info[3].As<Int32>()->Value();
+  CHECK_LE(offset + length, array_buffer->ByteLength());
+  int window_bits = info[4].As<Int32>()->Value();
+  if (type == static_cast<int32_t>(ZipType::GZIP)) {
+    window_bits += 16;
+  }
+  CHECK(info[5]->IsObject());
+  Local<Object> options = info[5].As<Object>();
+
+  ZlibStreamKey key{ZlibStreamKey::Mode::kDeflate,
+                    GetInt32Option(immortal, options, immortal->level_string()),
+                    window_bits,
+                    GetInt32Option(
+                        immortal, options, immortal->mem_level_string()),
+                    GetInt32Option(
+                        immortal, options, immortal->strategy_string())};
+  std::unique_ptr<z_stream> stream = AcquireDeflateStream(immortal, key);
+  if (stream == nullptr) {
+    ThrowException(isolate, "deflateInit() failed.");
+    return;
+  }
+
+  SyncOutput output;
+  if (!output.Reserve(deflateBound(stream.get(), length))) {
+    immortal->zlib_stream_pool()->Release(key, std::move(stream));
+    ThrowException(isolate, "Out of memory.");
+    return;
+  }
+
+  stream->next_in =
+      static_cast<Bytef*>(array_buffer->GetBackingStore()->Data()) + offset;
+  stream->avail_in = length;
+  output.Prepare(stream.get());
+  // The output is bounded by deflateBound(), so a single call with Z_FINISH
+  // completes the stream.
+  int status = deflate(stream.get(), Z_FINISH);
+  output.Commit(stream.get());
+  Debug(DebugCategory::ZLIB,
+        "[call] deflate(Z_FINISH) in sync: %d, avail_in: %d\n",
+        status,
+        stream->avail_in);
+  immortal->zlib_stream_pool()->Release(key, std::move(stream));
+
+  if (status != Z_STREAM_END) {
+    char error_msg[128];
+    snprintf(error_msg,
+             sizeof(error_msg),
+             "deflate() failed with status %i.",
+             status);
+    ThrowException(isolate, error_msg);
+    return;
+  }
+
+  info.GetReturnValue().Set(output.Release(isolate));
+}
+
+AWORKER_METHOD(DecompressSync) {
+  Immortal* immortal = Immortal::GetCurrent(info);
+  Isolate* isolate = immortal->isolate();
+  HandleScope scope(isolate);
+
+  int32_t type = info[0].As<Int32>()->Value();
+  if (type < 0 || type >= UnzipWrapper::TypeEnumMax()) {
+    ThrowException(isolate,
+                   "Unsupported uncompression type.",
+                   ExceptionType::kRangeError);
+    return;
+  }
+  CHECK(info[1]->IsArrayBuffer());
+  Local<ArrayBuffer> array_buffer = info[1].As<ArrayBuffer>();
+  size_t offset = info[2].As<Int32>()->Value();
+  size_t length = info[3].As<Int32>()->Value();
+  CHECK_LE(offset + length, array_buffer->ByteLength());
+  int window_bits = info[4].As<Int32>()->Value();
+
+  if (length == 0) {
+    info.GetReturnValue().Set(ArrayBuffer::New(isolate, 0));
+    return;
+  }
+
+  const uint8_t* data =
+      static_cast<uint8_t*>(array_buffer->GetBackingStore()->Data()) + offset;
+  // The whole input is at hand, so the header can be sniffed up front.
+  if (type == static_cast<int32_t>(UnzipType::UNZIP)) {
+    type = length >= 2 && data[0] == GZIP_HEADER_ID1 &&
+                   data[1] == GZIP_HEADER_ID2
+               ? static_cast<int32_t>(UnzipType::GUNZIP)
+               : static_cast<int32_t>(UnzipType::INFLATE);
+  }
+  if (type == static_cast<int32_t>(UnzipType::GUNZIP)) {
+    window_bits += 16;
+  }
+
+  ZlibStreamKey key{ZlibStreamKey::Mode::kInflate, 0, window_bits, 0, 0};
+  std::unique_ptr<z_stream> stream = AcquireInflateStream(immortal, key);
+  if (stream == nullptr) {
+    ThrowException(isolate, "inflateInit() failed.");
+    return;
+  }
+
+  size_t capacity = ExpectedGzipOutputLength(data, length);
+  if (capacity == 0) {
+    capacity =
+        std::max(length * 4, static_cast<size_t>(ZLIB_SYNC_MIN_OUTPUT_SIZE));
+  }
+
+  SyncOutput output;
+  stream->next_in = const_cast<Bytef*>(data);
+  stream->avail_in = length;
+
+  int status = Z_OK;
+  char error_msg[128] = {0};
+  while (true) {
+    if (!output.Reserve(capacity)) {
+      snprintf(error_msg, sizeof(error_msg), "Out of memory.");
+      break;
+    }
+    output.Prepare(stream.get());
+    status = inflate(stream.get(), Z_FINISH);
+    output.Commit(stream.get());
+    Debug(DebugCategory::ZLIB,
+          "[call] inflate(Z_FINISH) in sync: %d, avail_in: %d, avail_out: "
+          "%d\n",
+          status,
+          stream->avail_in,
+          stream->avail_out);
+
+    if (status == Z_STREAM_END) break;
+    // Z_FINISH reports Z_BUF_ERROR if the output space runs out before the
+    // stream ends. Grow the output and continue.
+    if ((status == Z_BUF_ERROR || status == Z_OK) && output.full()) {
+      capacity = output.capacity() * 2;
+      continue;
+    }
+    if (status == Z_BUF_ERROR) {
+      snprintf(error_msg, sizeof(error_msg), "unexpected end of file");
+    } else {
+      snprintf(error_msg,
+               sizeof(error_msg),
+               "inflate() failed with status %i, %s.",
+               status == Z_NEED_DICT ? Z_DATA_ERROR : status,
+               stream->msg == nullptr ? "" : stream->msg);
+    }
+    break;
+  }
+  immortal->zlib_stream_pool()->Release(key, std::move(stream));
+
+  if (*error_msg != 0) {
+    ThrowException(isolate, error_msg);
+    return;
+  }
+
+  info.GetReturnValue().Set(output.Release(isolate));
+}
+
+}  // namespace zlib
+}  // namespace aworker
@@ -0,0 +1,34 @@
+#ifndef SRC_ZLIB_ZLIB_SYNC_H_
+#define SRC_ZLIB_ZLIB_SYNC_H_
+
+#include "aworker_binding.h"
+
+namespace aworker {
+namespace zlib {
+
+/**
+ * One-shot compression of a whole buffer on the calling thread:
+ *
+ *   compressSync(type, arrayBuffer, offset, length, windowBits, options)
+ *
+ * The output is sized with `deflateBound()` so that a single `deflate()` call
+ * with `Z_FINISH` completes the stream. No wrapper object or task is created,
+ * and the `z_stream` is taken from and returned to the per-isolate pool.
+ */
+AWORKER_METHOD(CompressSync);
+
+/**
+ * One-shot decompression of a whole buffer on the calling thread:
+ *
+ *   decompressSync(type, arrayBuffer, offset, length, windowBits)
+ *
+ * The output of gzip input is sized with the ISIZE of the trailer, so a single
+ * `inflate()` call completes the stream in the common case. The output is
+ * only grown if the hint is missing or too small.
+ */
+AWORKER_METHOD(DecompressSync);
+
+}  // namespace zlib
+}  // namespace aworker
+
+#endif  // SRC_ZLIB_ZLIB_SYNC_H_
@@ -1,3 +1,4 @@
+#include <algorithm>
 #include <memory>
 
 #include "debug_utils.h"
@@ -19,6 +20,9 @@ using v8::Local;
 using v8::Object;
 using v8::Value;
 
+#define ZLIB_MIN_OUTPUT_CHUNK_SIZE (4 * 1024)
+#define ZLIB_MAX_OUTPUT_CHUNK_SIZE (64 * 1024)
+
 ZlibTask::ZlibTask(Immortal* immortal,
                    ZlibWrapper* wrapper,
                    Local<Object> life_object,
@@ -56,7 +60,7 @@ void ZlibTask::OnDone() {
     }
     _parent->DoTaskCallback(this, 1, argv);
   } else {
-    ReleasedResizableBuffer ret = out()->Release();
+    ReleasedResizableBuffer ret = ReleaseOutput();
     shared_ptr<BackingStore> backing_store = ArrayBuffer::NewBackingStore(
         ret.buff,
         ret.byte_length,
@@ -72,8 +76,15 @@ void ZlibTask::OnDone() {
   _parent->TryTriggerNextTask();
 }
 
+void ZlibTask::SnapshotParent() {
+  _snapshotted = true;
+  _parent_finished = _parent->finished();
+  _parent_errored = _parent->errored();
+  _stream = _parent->stream();
+}
+
 void ZlibTask::Prepare() {
-  ZlibStreamPtr stream = _parent->stream();
+  ZlibStreamPtr stream = _stream;
 
   stream->avail_in = _input.byte_length();
   stream->next_in = static_cast<unsigned char*>(_input.data());
@@ -84,24 +95,163 @@ void ZlibTask::Prepare() {
 void ZlibTask::Done(bool all_done) {
   Debug(
       DebugCategory::ZLIB, "[trace] ZlibTask::Done(all_done: %d)\n", all_done);
-  if (all_done) _parent->End();
+  if (all_done) {
+    if (_offloaded) {
+      _pending_end = true;
+    } else {
+      _parent->End();
+    }
+  }
   MacroTask::Done();
 }
 
-void ZlibTask::ConcatChunkToResult(ZlibStreamPtr stream,
-                                   const ResizableBuffer& chunk) {
+struct ZlibTask::ThreadPoolWork {
+  uv_work_t req;
+  std::unique_ptr<ZlibTask> task;
+};
+
+// static
+void ZlibTask::RunOnThreadPool(uv_loop_t* loop,
+                               std::unique_ptr<ZlibTask> task) {
+  task->_offloaded = true;
+  // The stream is owned by the wrapper, keep the wrapper alive until the
+  // work is done.
+  task->_parent->ClearWeak();
+  ThreadPoolWork* work = new ThreadPoolWork();
+  work->task = std::move(task);
+  CHECK_EQ(uv_queue_work(
+               loop, &work->req, OnThreadPoolWork, OnThreadPoolWorkDone),
+           0);
+}
+
+// static
+void ZlibTask::RunAsyncWork(std::unique_ptr<ZlibTask> task) {
+  task->_offloaded = true;
+  // Keep the wrapper, and the compressor it owns, alive until the work is
+  // done. The task deletes itself in `AsyncWorkDone`.
+  task->_parent->ClearWeak();
+  task.release()->StartAsyncWork();
+}
+
+void ZlibTask::AsyncWorkDone() {
+  std::unique_ptr<ZlibTask> self(this);
+  OffloadedDone();
+}
+
+// static
+void ZlibTask::OnThreadPoolWork(uv_work_t* req) {
+  ThreadPoolWork* work = ContainerOf(&ThreadPoolWork::req, req);
+  ZlibTask* task = work->task.get();
+  while (!task->is_done() && !task->has_error()) {
+    task->OnWorkTick();
+  }
+}
+
+// static
+void ZlibTask::OnThreadPoolWorkDone(uv_work_t* req, int status) {
+  std::unique_ptr<ThreadPoolWork> work(
+      ContainerOf(&ThreadPoolWork::req, req));
+  ZlibTask* task = work->task.get();
+  if (status == UV_ECANCELED) {
+    task->Fail("Zlib task canceled.");
+  }
+  task->OffloadedDone();
+}
+
+void ZlibTask::OffloadedDone() {
+  if (_pending_end) {
+    _parent->End();
+  }
+  // OnDone may schedule the next task of the wrapper, which holds the
+  // wrapper again. The wrapper object is still retained by the task until
+  // the task is deleted.
+  _parent->MakeWeak();
+  // Errors are reported, and the next task is triggered, by OnDone.
+  OnDone();
+}
+
+void ZlibTask::PrepareOutput(ZlibStreamPtr stream) {
+  if (_out_chunks.empty() ||
+      _out_chunk_length == _out_chunks.back().byte_length()) {
+    size_t size = ZLIB_MIN_OUTPUT_CHUNK_SIZE;
+    if (!_out_chunks.empty()) {
+      size = std::max(size,
+                      std::min(_out_chunks.back().byte_length() * 2,
+                               static_cast<size_t>(ZLIB_MAX_OUTPUT_CHUNK_SIZE)));
+    }
+    _out_chunks.emplace_back(size);
+    _out_chunk_length = 0;
+  }
+
+  ResizableBuffer& chunk = _out_chunks.back();
+  stream->next_out =
+      static_cast<unsigned char*>(chunk.buffer()) + _out_chunk_length;
+  stream->avail_out = chunk.byte_length() - _out_chunk_length;
+}
+
+void ZlibTask::CommitOutput(ZlibStreamPtr stream) {
+  ResizableBuffer& chunk = _out_chunks.back();
   CHECK_GE(chunk.byte_length(), stream->avail_out);
-  size_t n = chunk.byte_length() - stream->avail_out;
+  size_t end = chunk.byte_length() - stream->avail_out;
+  CHECK_GE(end, _out_chunk_length);
+  size_t n = end - _out_chunk_length;
   per_process::Debug(DebugCategory::ZLIB,
-                     "[record] ZlibTask::ConcatChunkToResult(stream, chunk): "
+                     "[record] ZlibTask::CommitOutput(stream): "
                      "chunk length: %d\n",
                      n);
 
-  if (n == 0) {
+  _out_chunk_length = end;
+  _out_byte_length += n;
+}
+
+void ZlibTask::AppendOutput(ResizableBuffer buffer) {
+  if (buffer.byte_length() == 0) {
     return;
   }
+  // Keep all chunks but the last one full.
+  if (!_out_chunks.empty()) {
+    _out_chunks.back().Realloc(_out_chunk_length);
+  }
+  _out_chunk_length = buffer.byte_length();
+  _out_byte_length += buffer.byte_length();
+  _out_chunks.push_back(std::move(buffer));
+}
+
+void ZlibTask::ReserveOutput(size_t byte_length) {
+  if (!_out_chunks.empty() || byte_length == 0) {
+    return;
+  }
+  _out_chunks.emplace_back(byte_length);
+  _out_chunk_length = 0;
+}
+
+ReleasedResizableBuffer ZlibTask::ReleaseOutput() {
+  if (!_out_chunks.empty() && _out_chunk_length == 0) {
+    _out_chunks.pop_back();
+    _out_chunk_length =
+        _out_chunks.empty() ? 0 : _out_chunks.back().byte_length();
+  }
+
+  ResizableBuffer result;
+  if (_out_chunks.size() == 1) {
+    result = std::move(_out_chunks.front());
+    result.Realloc(_out_byte_length);
+  } else if (_out_chunks.size() > 1) {
+    result.Realloc(_out_byte_length);
+    char* ptr = static_cast<char*>(result.buffer());
+    for (size_t idx = 0; idx < _out_chunks.size(); idx++) {
+      const ResizableBuffer& chunk = _out_chunks[idx];
+      size_t length = idx == _out_chunks.size() - 1 ? _out_chunk_length
+                                                    : chunk.byte_length();
+      memcpy(ptr, chunk.buffer(), length);
+      ptr += length;
+    }
+  }
 
-  _out_buffer.Concat(chunk, n);
+  _out_chunks.clear();
+  _out_chunk_length = 0;
+  _out_byte_length = 0;
+  return result.Release();
 }
 
 }  // namespace zlib
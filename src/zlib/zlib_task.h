@@ -5,6 +5,9 @@ extern "C" {
 #include <zlib.h>
 }
 
+#include <memory>
+#include <vector>
+
 #include "immortal.h"
 #include "macro_task_queue.h"
 #include "utils/convenient_array_buffer_store.h"
@@ -32,15 +35,54 @@ class ZlibTask : public MacroTask {
   void OnDone() override;
   void OnWorkTick() override = 0;
 
+  /**
+   * Run all ticks of the task on the libuv thread pool, the task is done on
+   * the loop thread once it's finished.
+   */
+  static void RunOnThreadPool(uv_loop_t* loop, std::unique_ptr<ZlibTask> task);
+  /**
+   * Start the task that completes by itself instead of being ticked, e.g. the
+   * parallel gzip task dispatching its blocks to the libuv thread pool. The
+   * task is done on the loop thread once it calls `AsyncWorkDone`.
+   */
+  static void RunAsyncWork(std::unique_ptr<ZlibTask> task);
+  virtual bool IsAsyncWork() { return false; }
+
   inline Immortal* immortal() { return _immortal; }
-  inline ResizableBuffer* out() { return &_out_buffer; }
+  /**
+   * Returns the output as one buffer, it's only copied if the output spans
+   * over multiple chunks.
+   */
+  ReleasedResizableBuffer ReleaseOutput();
+  /**
+   * Snapshots the wrapper state the ticks depend on. Tasks offloaded to the
+   * libuv thread pool take the snapshot on the loop thread before being
+   * queued, so that their ticks never touch the wrapper off the loop thread.
+   */
+  virtual void SnapshotParent();
   inline size_t byte_length() { return _input.byte_length(); }
   inline void* data() { return _input.data(); }
 
  protected:
   void Prepare();
   void Done(bool all_done);
-  void ConcatChunkToResult(ZlibStreamPtr stream, const ResizableBuffer& chunk);
+  inline void EnsureParentSnapshot() {
+    if (!_snapshotted) SnapshotParent();
+  }
+  /**
+   * Points `next_out` of the stream to the free space of the output chunks,
+   * and records the bytes written by the stream after the zlib call.
+   */
+  void PrepareOutput(ZlibStreamPtr stream);
+  void CommitOutput(ZlibStreamPtr stream);
+  void AppendOutput(ResizableBuffer buffer);
+  /**
+   * Sizes the first output chunk if the output length is known up front, so
+   * that the zlib call can finish in one go without any further copy.
+   */
+  void ReserveOutput(size_t byte_length);
+  virtual void StartAsyncWork() { UNREACHABLE(); }
+  void AsyncWorkDone();
 
   ConvenientArrayBufferStore _input;
   Immortal* _immortal;
@@ -48,10 +90,30 @@ class ZlibTask : public MacroTask {
   ZlibWrapper* _parent;
   v8::Global<v8::Object> _life_object;
 
-  ResizableBuffer _out_buffer;
+  // Wrapper state snapshotted by `SnapshotParent`.
+  bool _snapshotted = false;
+  bool _parent_finished = false;
+  bool _parent_errored = false;
+  ZlibStreamPtr _stream = nullptr;
+
+  // Output is collected in chunks of growing size to avoid reallocating and
+  // copying the whole output for every zlib call.
+  std::vector<ResizableBuffer> _out_chunks;
+  size_t _out_chunk_length = 0;
+  size_t _out_byte_length = 0;
   int32_t _flush_mode;
 
+  // The wrapper can only be ended on the loop thread.
+  bool _offloaded = false;
+  bool _pending_end = false;
+
   using MacroTask::Done;
+
+ private:
+  struct ThreadPoolWork;
+  void OffloadedDone();
+  static void OnThreadPoolWork(uv_work_t* req);
+  static void OnThreadPoolWorkDone(uv_work_t* req, int status);
 };
 
 }  // namespace zlib
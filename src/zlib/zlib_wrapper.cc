@@ -1,9 +1,11 @@
 #include "zlib_wrapper.h"
+#include "command_parser.h"
 #include "debug_utils.h"
 #include "error_handling.h"
 #include "unzip.h"
 #include "util.h"
 #include "zip.h"
+#include "zlib_sync.h"
 
 namespace aworker {
 namespace zlib {
@@ -34,8 +36,6 @@ using v8::ObjectTemplate;
 using v8::String;
 using v8::Value;
 
-int pagesize = getpagesize();
-
 template <class T, typename TypeEnum>
 inline void ZlibWrapper::Init(Local<Object> exports,
                               const char* constructor_name) {
@@ -61,6 +61,8 @@ inline void ZlibWrapper::Init(Local<Object> exports,
   immortal->SetFunctionProperty(prototype_template, "hasError", HasError<T>);
   immortal->SetFunctionProperty(
       prototype_template, "errorMessage", ErrorMessage<T>);
+  immortal->SetFunctionProperty(
+      prototype_template, "isParallel", IsParallel<T>);
 
   exports->Set(context, name, tpl->GetFunction(context).ToLocalChecked())
       .Check();
@@ -73,6 +75,7 @@ inline void ZlibWrapper::Init(ExternalReferenceRegistry* registry) {
   registry->Register(IsDone<T>);
   registry->Register(HasError<T>);
   registry->Register(ErrorMessage<T>);
+  registry->Register(IsParallel<T>);
 }
 
 template <class T, typename TypeEnum>
@@ -171,6 +174,16 @@ inline AWORKER_METHOD(ZlibWrapper::ErrorMessage) {
   }
 }
 
+template <class T>
+inline AWORKER_METHOD(ZlibWrapper::IsParallel) {
+  Immortal* immortal = Immortal::GetCurrent(info);
+  Isolate* isolate = immortal->isolate();
+  HandleScope scope(isolate);
+  T* wrapper;
+  ASSIGN_OR_RETURN_UNWRAP(&wrapper, info.This());
+  info.GetReturnValue().Set(wrapper->parallel());
+}
+
 ZlibWrapper::ZlibWrapper(Immortal* immortal,
                          Local<Object> handle,
                          int type,
@@ -180,7 +193,9 @@ ZlibWrapper::ZlibWrapper(Immortal* immortal,
     : AsyncWrap(immortal, handle),
       _type(type),
       _is_sync(is_sync),
+      _offload(!is_sync && immortal->commandline_parser()->zlib_threadpool()),
       _window_bits(window_bits),
+      _stream_ready(false),
       _task_queue_processed(0),
       _running(false),
       _errored(false),
@@ -191,13 +206,8 @@ ZlibWrapper::ZlibWrapper(Immortal* immortal,
   // TODO(chengzhong.wcz): clarify js-native object lifetime
   MakeWeak();
 
-  memset(&_stream, 0, sizeof(_stream));
-
-  _chunk_buffer.Realloc(pagesize);
-  _stream.next_in = nullptr;
-  _stream.next_out = static_cast<unsigned char*>(_chunk_buffer.buffer());
-  _stream.avail_in = 0;
-  _stream.avail_out = _chunk_buffer.byte_length();
+  // Value-initialized, i.e. zeroed.
+  _stream = std::make_unique<ZlibStream>();
 }
 
 MaybeLocal<Value> ZlibWrapper::ReturnEmptyResultSyncOrAsync(
@@ -215,13 +225,28 @@ MaybeLocal<Value> ZlibWrapper::ReturnEmptyResultSyncOrAsync(
 
 void ZlibWrapper::TryTriggerNextTask() {
   if (!_task_queue.empty()) {
-    immortal()->macro_task_queue()->Enqueue(std::move(_task_queue.front()));
+    Schedule(std::move(_task_queue.front()));
     _task_queue.pop();
   } else {
     _running = false;
   }
 }
 
+void ZlibWrapper::Schedule(std::unique_ptr<ZlibTask> task) {
+  // The previous task is done, snapshot the state this task depends on.
+  task->SnapshotParent();
+  if (task->IsAsyncWork()) {
+    ZlibTask::RunAsyncWork(std::move(task));
+    return;
+  }
+  if (_offload) {
+    ZlibTask::RunOnThreadPool(immortal()->event_loop(), std::move(task));
+    return;
+  }
+  immortal()->macro_task_queue()->Enqueue(std::move(task),
+                                          MacroTaskPriority::kBackground);
+}
+
 void ZlibWrapper::DoTaskCallback(const ZlibTask* key,
                                  int argc,
                                  Local<Value>* argv) {
@@ -259,6 +284,26 @@ void ZlibWrapper::OccurError(const char* error) {
   DoZlibEnd();
 }
 
+bool ZlibWrapper::AcquireStream(const ZlibStreamKey& key) {
+  _stream_key = key;
+  std::unique_ptr<ZlibStream> stream =
+      immortal()->zlib_stream_pool()->Acquire(key);
+  if (stream == nullptr) {
+    return false;
+  }
+  _stream = std::move(stream);
+  _stream_ready = true;
+  return true;
+}
+
+void ZlibWrapper::ReleaseStream() {
+  if (!_stream_ready) {
+    return;
+  }
+  _stream_ready = false;
+  immortal()->zlib_stream_pool()->Release(_stream_key, std::move(_stream));
+}
+
 void ZlibWrapper::End() {
   _running = false;
   _finished = true;
@@ -269,6 +314,8 @@ void ZlibWrapper::End() {
 AWORKER_BINDING(Init) {
   ZlibWrapper::Init<UnzipWrapper, UnzipType>(exports, "UnzipWrapper");
   ZlibWrapper::Init<ZipWrapper, ZipType>(exports, "ZipWrapper");
+  immortal->SetFunctionProperty(exports, "compressSync", CompressSync);
+  immortal->SetFunctionProperty(exports, "decompressSync", DecompressSync);
 
   Local<Object> flush = Object::New(immortal->isolate());
 #define SET_FLUSH_MODE(name) immortal->SetIntegerProperty(flush, #name, name)
@@ -329,6 +376,8 @@ AWORKER_BINDING(Init) {
 AWORKER_EXTERNAL_REFERENCE(Init) {
   ZlibWrapper::Init<UnzipWrapper, UnzipType>(registry);
   ZlibWrapper::Init<ZipWrapper, ZipType>(registry);
+  registry->Register(CompressSync);
+  registry->Register(DecompressSync);
 }
 
 }  // namespace zlib
@@ -9,6 +9,7 @@ extern "C" {
 
 #include "async_wrap.h"
 #include "aworker_binding.h"
+#include "zlib_stream_pool.h"
 #include "zlib_task.h"
 
 namespace aworker {
@@ -33,6 +34,8 @@ class ZlibWrapper : public AsyncWrap {
   static AWORKER_METHOD(HasError);
   template <class T>
   static AWORKER_METHOD(ErrorMessage);
+  template <class T>
+  static AWORKER_METHOD(IsParallel);
 
   static int TypeEnumMax() { return 0; }
 
@@ -48,6 +51,7 @@ class ZlibWrapper : public AsyncWrap {
   v8::MaybeLocal<v8::Value> ReturnEmptyResultSyncOrAsync(
       v8::Isolate* isolate, v8::Local<v8::Function> callback, ZlibTask* task);
   void TryTriggerNextTask();
+  void Schedule(std::unique_ptr<ZlibTask> task);
 
   virtual bool Init() = 0;
   virtual v8::MaybeLocal<v8::Value> Push(
@@ -68,30 +72,40 @@ class ZlibWrapper : public AsyncWrap {
   void End();
   virtual void DoZlibEnd() = 0;
 
+  /**
+   * Takes an idle stream of the key from the per-isolate pool, returns false
+   * if the stream should be initialized by the caller.
+   */
+  bool AcquireStream(const ZlibStreamKey& key);
+  /**
+   * Returns the stream to the per-isolate pool.
+   */
+  void ReleaseStream();
+
   template <typename T>
   inline T type() {
     return static_cast<T>(_type);
   }
-  inline ZlibStreamPtr stream() { return &_stream; }
+  inline ZlibStreamPtr stream() { return _stream.get(); }
   inline bool finished() { return _finished; }
   inline bool errored() { return _errored; }
   inline std::string error() { return _error; }
   inline bool ended() { return _ended; }
-
-  /**
-   * All tasks belong to same `ZlibWrapper` should use the same chunk buffer to
-   * reduce frequent memory creation / release. So here's a
-   * `ZlibWrapper::chunk_buffer()` for all tasks belong to current
-   * `ZlibWrapper`.
-   */
-  inline ResizableBuffer* chunk_buffer() { return &_chunk_buffer; }
+  // Whether the stream is processed in parallel blocks.
+  virtual bool parallel() { return false; }
 
  protected:
-  ResizableBuffer _chunk_buffer;
   int _type;
   bool _is_sync;
+  // Run the asynchronous tasks on the libuv thread pool instead of the macro
+  // task queue.
+  bool _offload;
   int _window_bits;
-  ZlibStream _stream;
+  std::unique_ptr<ZlibStream> _stream;
+  ZlibStreamKey _stream_key;
+  // Whether `_stream` has been initialized successfully and should be
+  // released.
+  bool _stream_ready;
   std::queue<std::unique_ptr<ZlibTask>> _task_queue;
   CallbackMap _callback_map;
 
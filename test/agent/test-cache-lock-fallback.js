@@ -0,0 +1,20 @@
+// META: same-origin-shared-data=true
+// META: flags=--cache-storage-agent-lock --expose-internals
+'use strict';
+
+const binding = loadBinding('cache');
+
+promise_test(async () => {
+  await caches.delete('v1');
+  const cache = await caches.open('v1');
+
+  const fd = binding.tryLockResource('[CachePage]v1', true);
+  assert_true(fd < 0 && fd !== binding.kLockWouldBlock, 'local resource locks unavailable');
+
+  await Promise.all([
+    cache.put('http://foobar/first', new Response('first')),
+    cache.put('http://foobar/second', new Response('second')),
+  ]);
+  assert_equals(await (await cache.match('http://foobar/first')).text(), 'first');
+  assert_equals(await (await cache.match('http://foobar/second')).text(), 'second');
+}, 'fallback to agent resource locks');
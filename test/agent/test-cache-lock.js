@@ -0,0 +1,52 @@
+// META: same-origin-shared-data=true
+// META: flags=--expose-internals
+'use strict';
+
+const binding = loadBinding('cache');
+
+promise_test(async () => {
+  // Initialize the cache storage binding.
+  await caches.open('v1');
+
+  const resourceId = '[CachePage]lock-test';
+  const exclusive = binding.tryLockResource(resourceId, true);
+  assert_true(exclusive >= 0, 'exclusive lock acquired');
+  assert_equals(binding.tryLockResource(resourceId, true), binding.kLockWouldBlock);
+  assert_equals(binding.tryLockResource(resourceId, false), binding.kLockWouldBlock);
+  binding.unlockResource(resourceId, exclusive);
+
+  const first = binding.tryLockResource(resourceId, false);
+  const second = binding.tryLockResource(resourceId, false);
+  assert_true(first >= 0 && second >= 0, 'shared locks acquired');
+  assert_equals(binding.tryLockResource(resourceId, true), binding.kLockWouldBlock);
+  // The lock file is kept while another holder is still holding it.
+  binding.unlockResource(resourceId, first);
+  assert_equals(binding.tryLockResource(resourceId, true), binding.kLockWouldBlock);
+  binding.unlockResource(resourceId, second);
+
+  const last = binding.tryLockResource(resourceId, true);
+  assert_true(last >= 0, 'exclusive lock acquired after all shared locks released');
+  binding.unlockResource(resourceId, last);
+}, 'local resource locks');
+
+promise_test(async () => {
+  await caches.delete('v1');
+  const cache = await caches.open('v1');
+
+  const resourceId = '[CachePage]v1';
+  const fd = binding.tryLockResource(resourceId, true);
+  assert_true(fd >= 0);
+
+  let done = false;
+  const put = cache.put('http://foobar/lock', new Response('foo'))
+    .then(() => {
+      done = true;
+    });
+  await new Promise(resolve => setTimeout(resolve, 50));
+  assert_false(done, 'put waits for the lock');
+
+  binding.unlockResource(resourceId, fd);
+  await put;
+  const resp = await cache.match('http://foobar/lock');
+  assert_equals(await resp.text(), 'foo');
+}, 'retry contended local resource locks');
@@ -0,0 +1,68 @@
+// META: same-origin-shared-data=true
+// META: flags=--cache-storage-quota-mb=1 --expose-internals
+'use strict';
+
+const { waitForEviction } = load('cache');
+
+const kBodySize = 768 * 1024;
+
+promise_test(async () => {
+  await caches.delete('v1');
+  const cache = await caches.open('v1');
+
+  await cache.put('http://foobar/first', new Response(new Uint8Array(kBodySize)));
+  await cache.put('http://foobar/second', new Response(new Uint8Array(kBodySize)));
+  // Eviction is performed in background.
+  await waitForEviction();
+
+  const first = await cache.match('http://foobar/first');
+  assert_equals(first, undefined, 'least recently written entry evicted');
+  const second = await cache.match('http://foobar/second');
+  assert_true(second != null, 'recently written entry kept');
+  assert_equals((await second.arrayBuffer()).byteLength, kBodySize);
+}, 'CacheStorage: evict entries exceeding quota');
+
+promise_test(async () => {
+  await caches.delete('v1');
+  const cache = await caches.open('v1');
+
+  await cache.put('http://foobar/first', new Response(new Uint8Array(kBodySize)));
+  await caches.delete('v1');
+  const reopened = await caches.open('v1');
+  await reopened.put('http://foobar/second', new Response(new Uint8Array(kBodySize)));
+  await waitForEviction();
+
+  const second = await reopened.match('http://foobar/second');
+  assert_true(second != null, 'usage of deleted cache is released');
+}, 'CacheStorage: release usage on cache deletion');
+
+promise_test(async () => {
+  await caches.delete('v1');
+  await caches.delete('v2');
+  const v1 = await caches.open('v1');
+  const v2 = await caches.open('v2');
+
+  await v1.put('http://foobar/first', new Response(new Uint8Array(kBodySize)));
+  // Make sure the entries are written in different milliseconds.
+  await new Promise(resolve => setTimeout(resolve, 2));
+  await v2.put('http://foobar/second', new Response(new Uint8Array(kBodySize)));
+  await waitForEviction();
+
+  assert_equals(await v1.match('http://foobar/first'), undefined, 'evicted across caches');
+  assert_true(await v2.match('http://foobar/second') != null);
+}, 'CacheStorage: evict least recently written entries across caches');
+
+promise_test(async () => {
+  await caches.delete('v1');
+  const cache = await caches.open('v1');
+
+  await cache.put('http://foobar/first', new Response(new Uint8Array(kBodySize)));
+  await cache.put('http://foobar/second', new Response(new Uint8Array(kBodySize)));
+  // Race the eviction in background.
+  await caches.delete('v1');
+  await waitForEviction();
+
+  assert_false(await caches.has('v1'));
+  const reopened = await caches.open('v1');
+  assert_equals((await reopened.keys()).length, 0, 'deleted cache is not recreated by eviction');
+}, 'CacheStorage: delete a cache while evicting its entries');
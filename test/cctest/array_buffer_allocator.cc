@@ -0,0 +1,101 @@
+#include "array_buffer_allocator.h"
+#include <gtest/gtest.h>
+#include <cstring>
+#include <thread>  // NOLINT(build/c++11)
+#include <vector>
+
+namespace aworker {
+
+TEST(ArrayBufferAllocator, Recycle) {
+  ArrayBufferAllocator allocator;
+  void* data = allocator.Allocate(100);
+  ASSERT_NE(data, nullptr);
+  memset(data, 0xff, 100);
+  allocator.Free(data, 100);
+  EXPECT_EQ(allocator.GetStatistics().pooled_bytes, 128u);
+
+  // Buffers of the same size class are recycled, and zero filled.
+  char* recycled = static_cast<char*>(allocator.Allocate(120));
+  EXPECT_EQ(recycled, data);
+  for (int idx = 0; idx < 120; idx++) {
+    EXPECT_EQ(recycled[idx], 0);
+  }
+  allocator.Free(recycled, 120);
+
+  ArrayBufferAllocator::Statistics stats = allocator.GetStatistics();
+  EXPECT_EQ(stats.allocations, 2u);
+  EXPECT_EQ(stats.pooled_allocations, 1u);
+  EXPECT_EQ(stats.allocated_bytes, 0u);
+  EXPECT_EQ(stats.pooled_bytes, 128u);
+}
+
+TEST(ArrayBufferAllocator, LargeBuffers) {
+  ArrayBufferAllocator allocator;
+  size_t length = ArrayBufferAllocator::kMaxPooledSize + 1;
+  void* data = allocator.Allocate(length);
+  ASSERT_NE(data, nullptr);
+  EXPECT_EQ(allocator.GetStatistics().allocated_bytes, length);
+  allocator.Free(data, length);
+
+  ArrayBufferAllocator::Statistics stats = allocator.GetStatistics();
+  EXPECT_EQ(stats.allocated_bytes, 0u);
+  EXPECT_EQ(stats.pooled_bytes, 0u);
+}
+
+TEST(ArrayBufferAllocator, PooledBytesLimit) {
+  ArrayBufferAllocator allocator;
+  size_t count = ArrayBufferAllocator::kMaxPooledBytesPerClass /
+                     ArrayBufferAllocator::kMaxPooledSize +
+                 1;
+  std::vector<void*> buffers;
+  for (size_t idx = 0; idx < count; idx++) {
+    buffers.push_back(
+        allocator.AllocateUninitialized(ArrayBufferAllocator::kMaxPooledSize));
+  }
+  for (void* data : buffers) {
+    allocator.Free(data, ArrayBufferAllocator::kMaxPooledSize);
+  }
+  EXPECT_EQ(allocator.GetStatistics().pooled_bytes,
+            ArrayBufferAllocator::kMaxPooledBytesPerClass);
+}
+
+TEST(ArrayBufferAllocator, NoZeroFillScope) {
+  ArrayBufferAllocator allocator;
+  void* data = allocator.Allocate(64);
+  memset(data, 0xff, 64);
+  allocator.Free(data, 64);
+  {
+    ArrayBufferAllocator::NoZeroFillScope no_zero_fill_scope;
+    unsigned char* recycled =
+        static_cast<unsigned char*>(allocator.Allocate(64));
+    EXPECT_EQ(recycled, data);
+    // The head of the buffer is overwritten by the freelist link.
+    EXPECT_EQ(recycled[63], 0xff);
+    allocator.Free(recycled, 64);
+  }
+  unsigned char* recycled = static_cast<unsigned char*>(allocator.Allocate(64));
+  EXPECT_EQ(recycled[63], 0);
+  allocator.Free(recycled, 64);
+}
+
+TEST(ArrayBufferAllocator, MultiThread) {
+  ArrayBufferAllocator allocator;
+  std::vector<std::thread> threads;
+  for (int idx = 0; idx < 4; idx++) {
+    threads.emplace_back([&allocator]() {
+      for (int round = 0; round < 1000; round++) {
+        size_t length = 1 + round % 4096;
+        void* data = allocator.Allocate(length);
+        allocator.Free(data, length);
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  ArrayBufferAllocator::Statistics stats = allocator.GetStatistics();
+  EXPECT_EQ(stats.allocations, 4000u);
+  EXPECT_EQ(stats.allocated_bytes, 0u);
+}
+
+}  // namespace aworker
@@ -249,6 +249,41 @@ TEST(AworkerPlatformForegroundTaskRunner, InterwinedDuringReschedule) {
   uv_close(reinterpret_cast<uv_handle_t*>(&idle), nullptr);
 }
 
+class TestIdleTask : public v8::IdleTask {
+ public:
+  explicit TestIdleTask(double* deadline) : _deadline(deadline) {}
+  void Run(double deadline_in_seconds) override {
+    *_deadline = deadline_in_seconds;
+  }
+
+ private:
+  double* _deadline;
+};
+
+TEST(AworkerPlatformForegroundTaskRunner, PostIdleTask) {
+  AworkerPlatform platform(AworkerPlatform::kSingleThread);
+  uv_loop_t* loop = platform.loop();
+  auto runner = platform.GetForegroundTaskRunner(nullptr);
+  platform.task_runner()->set_idle_tasks_enabled(true);
+  EXPECT_TRUE(platform.IdleTasksEnabled(nullptr));
+
+  // A pending timer keeps the loop alive while leaving it idle until the
+  // timer expires.
+  uv_timer_t timer;
+  ASSERT_EQ(uv_timer_init(loop, &timer), 0);
+  ASSERT_EQ(uv_timer_start(&timer, [](uv_timer_t* handle) {}, 10, 10), 0);
+
+  double deadline = 0;
+  runner->PostIdleTask(std::make_unique<TestIdleTask>(&deadline));
+  double start = platform.MonotonicallyIncreasingTime();
+  uv_run(loop, UV_RUN_ONCE);
+  EXPECT_GT(deadline, start);
+  // The idle period never exceeds the next timer.
+  EXPECT_LE(deadline, start + 0.01 + 0.001);
+
+  uv_close(reinterpret_cast<uv_handle_t*>(&timer), nullptr);
+}
+
 TEST(AworkerPlatformSingleThread, NumberOfWorkerThreads) {
   AworkerPlatform platform(AworkerPlatform::kSingleThread);
   EXPECT_EQ(platform.NumberOfWorkerThreads(), 0);
@@ -2,6 +2,7 @@
 #include <gtest/gtest.h>
 #include <unistd.h>
 #include <iostream>
+#include <vector>
 #include "common.h"
 #include "util.h"
 
@@ -22,6 +23,44 @@ class TestTask : public MacroTask {
   int _times;
 };
 
+class OrderedTask : public MacroTask {
+ public:
+  OrderedTask(std::vector<int>* order, int id) : _order(order), _id(id) {}
+  void OnWorkTick() {
+    _order->push_back(_id);
+    Done();
+  }
+
+ private:
+  std::vector<int>* _order;
+  int _id;
+};
+
+class SlicedTask : public MacroTask {
+ public:
+  SlicedTask(std::vector<int>* order, int id, int slices, int first_slice_ms)
+      : _order(order),
+        _id(id),
+        _slices(slices),
+        _first_slice_ms(first_slice_ms) {}
+  void OnWorkTick() {
+    if (_first_slice_ms > 0) {
+      usleep(_first_slice_ms * 1000);
+      _first_slice_ms = 0;
+    }
+    _order->push_back(_id);
+    if (--_slices == 0) {
+      Done();
+    }
+  }
+
+ private:
+  std::vector<int>* _order;
+  int _id;
+  int _slices;
+  int _first_slice_ms;
+};
+
 }  // namespace
 
 TEST(MacroTaskQueue, EachTickShouldScheduleNextTickImmediately) {
@@ -55,4 +94,80 @@ TEST(MacroTaskQueue, EachTickShouldScheduleNextTickImmediately) {
 
   assert_uv_loop_close(&loop);
 }
+
+TEST(MacroTaskQueue, TimeBudgetShouldProcessCheapSlicesInOneTick) {
+  uv_loop_t loop;
+  uv_loop_init(&loop);
+  uv_prepare_t prepare;
+
+  struct Data {
+    int count = 0;
+    int count_at_first_prepare = -1;
+  } data;
+
+  {
+    // The count limit is overridden by the time budget.
+    std::shared_ptr<MacroTaskQueue> macro_task_queue =
+        MacroTaskQueue::Create(&loop, 1, 1000 * 1000);
+    EXPECT_EQ(macro_task_queue->time_budget_us(), 1000 * 1000);
+    macro_task_queue->Enqueue(std::make_unique<TestTask>(&data.count, 100));
+
+    // Idle handles are run before prepare handles in the same loop iteration.
+    uv_prepare_init(&loop, &prepare);
+    prepare.data = &data;
+    uv_prepare_start(&prepare, [](uv_prepare_t* prepare) {
+      Data* data = reinterpret_cast<Data*>(prepare->data);
+      data->count_at_first_prepare = data->count;
+      uv_close(reinterpret_cast<uv_handle_t*>(prepare), nullptr);
+    });
+
+    uv_run(&loop, UV_RUN_DEFAULT);
+    EXPECT_EQ(data.count, 100);
+  }
+  // All slices are processed in the first loop iteration.
+  EXPECT_EQ(data.count_at_first_prepare, 100);
+
+  assert_uv_loop_close(&loop);
+}
+
+TEST(MacroTaskQueue, HigherPriorityShouldBeProcessedFirst) {
+  uv_loop_t loop;
+  uv_loop_init(&loop);
+
+  std::vector<int> order;
+  {
+    std::shared_ptr<MacroTaskQueue> macro_task_queue =
+        MacroTaskQueue::Create(&loop, 1);
+    macro_task_queue->Enqueue(std::make_unique<OrderedTask>(&order, 0),
+                              MacroTaskPriority::kBackground);
+    macro_task_queue->Enqueue(std::make_unique<OrderedTask>(&order, 1));
+    macro_task_queue->Enqueue(std::make_unique<OrderedTask>(&order, 2),
+                              MacroTaskPriority::kUserBlocking);
+    uv_run(&loop, UV_RUN_DEFAULT);
+  }
+  EXPECT_EQ(order, std::vector<int>({2, 1, 0}));
+
+  assert_uv_loop_close(&loop);
+}
+
+TEST(MacroTaskQueue, RequeuedTaskShouldKeepAging) {
+  uv_loop_t loop;
+  uv_loop_init(&loop);
+
+  std::vector<int> order;
+  {
+    std::shared_ptr<MacroTaskQueue> macro_task_queue =
+        MacroTaskQueue::Create(&loop, 1);
+    macro_task_queue->Enqueue(std::make_unique<SlicedTask>(&order, 0, 2, 0),
+                              MacroTaskPriority::kBackground);
+    // The first slice outlasts the aging threshold of background tasks.
+    macro_task_queue->Enqueue(std::make_unique<SlicedTask>(&order, 1, 2, 1100),
+                              MacroTaskPriority::kUserBlocking);
+    uv_run(&loop, UV_RUN_DEFAULT);
+  }
+  // The aged background task is processed until done.
+  EXPECT_EQ(order, std::vector<int>({1, 0, 0, 1}));
+
+  assert_uv_loop_close(&loop);
+}
 }  // namespace aworker
@@ -0,0 +1,74 @@
+#include "utils/mpsc_queue.h"
+#include <gtest/gtest.h>
+#include <thread>  // NOLINT(build/c++11)
+#include <vector>
+
+namespace aworker {
+
+namespace {
+class Item : public MpscQueueNode {
+ public:
+  Item(int producer, int seq) : producer(producer), seq(seq) {}
+
+  int producer;
+  int seq;
+};
+}  // namespace
+
+TEST(MpscQueue, PopEmpty) {
+  MpscQueue<Item> queue;
+  EXPECT_EQ(queue.Pop(), nullptr);
+}
+
+TEST(MpscQueue, FirstInFirstOut) {
+  MpscQueue<Item> queue;
+  Item items[] = {{0, 0}, {0, 1}, {0, 2}};
+  for (auto& item : items) {
+    queue.Push(&item);
+  }
+  for (auto& item : items) {
+    EXPECT_EQ(queue.Pop(), &item);
+  }
+  EXPECT_EQ(queue.Pop(), nullptr);
+
+  // The queue can be reused after drained.
+  queue.Push(&items[1]);
+  EXPECT_EQ(queue.Pop(), &items[1]);
+  EXPECT_EQ(queue.Pop(), nullptr);
+}
+
+TEST(MpscQueue, MultipleProducers) {
+  constexpr int kProducers = 4;
+  constexpr int kItemsPerProducer = 10000;
+  MpscQueue<Item> queue;
+
+  std::vector<std::thread> producers;
+  for (int idx = 0; idx < kProducers; idx++) {
+    producers.emplace_back([&queue, idx]() {
+      for (int seq = 0; seq < kItemsPerProducer; seq++) {
+        queue.Push(new Item(idx, seq));
+      }
+    });
+  }
+
+  std::vector<int> next_seq(kProducers, 0);
+  int popped = 0;
+  while (popped < kProducers * kItemsPerProducer) {
+    Item* item = queue.Pop();
+    if (item == nullptr) {
+      std::this_thread::yield();
+      continue;
+    }
+    // Items of one producer are popped in the order they were pushed.
+    EXPECT_EQ(item->seq, next_seq[item->producer]);
+    next_seq[item->producer]++;
+    popped++;
+    delete item;
+  }
+  for (auto& producer : producers) {
+    producer.join();
+  }
+  EXPECT_EQ(queue.Pop(), nullptr);
+}
+
+}  // namespace aworker
@@ -0,0 +1,76 @@
+#include "worker_thread_pool.h"
+#include <gtest/gtest.h>
+#include <atomic>
+#include <chrono>  // NOLINT(build/c++11)
+#include <thread>  // NOLINT(build/c++11)
+#include "uv.h"
+
+namespace aworker {
+
+namespace {
+class CountTask : public v8::Task {
+ public:
+  CountTask(std::atomic<int>* count, WorkerThreadPool* pool, int fanout)
+      : _count(count), _pool(pool), _fanout(fanout) {}
+  void Run() override {
+    (*_count)++;
+    // Tasks posted from the workers are pushed to their own deques, and
+    // stolen by the idle workers.
+    for (int idx = 0; idx < _fanout; idx++) {
+      _pool->PostTask(std::make_unique<CountTask>(_count, _pool, 0));
+    }
+  }
+
+ private:
+  std::atomic<int>* _count;
+  WorkerThreadPool* _pool;
+  int _fanout;
+};
+
+class TimeTask : public v8::Task {
+ public:
+  explicit TimeTask(std::atomic<uint64_t>* time) : _time(time) {}
+  void Run() override { *_time = uv_hrtime(); }
+
+ private:
+  std::atomic<uint64_t>* _time;
+};
+
+template <typename Predicate>
+bool WaitFor(Predicate predicate) {
+  for (int idx = 0; idx < 500; idx++) {
+    if (predicate()) {
+      return true;
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  }
+  return predicate();
+}
+}  // namespace
+
+TEST(WorkerThreadPool, GetAvailableParallelism) {
+  int parallelism = GetAvailableParallelism();
+  EXPECT_GE(parallelism, 1);
+  EXPECT_LE(parallelism, static_cast<int>(std::thread::hardware_concurrency()));
+}
+
+TEST(WorkerThreadPool, PostTask) {
+  std::atomic<int> count{0};
+  WorkerThreadPool pool(4, false);
+  EXPECT_EQ(pool.thread_count(), 4);
+  for (int idx = 0; idx < 100; idx++) {
+    pool.PostTask(std::make_unique<CountTask>(&count, &pool, 10));
+  }
+  EXPECT_TRUE(WaitFor([&count]() { return count == 100 * 11; }));
+}
+
+TEST(WorkerThreadPool, PostDelayedTask) {
+  std::atomic<uint64_t> time{0};
+  WorkerThreadPool pool(1, true);
+  uint64_t start = uv_hrtime();
+  pool.PostDelayedTask(std::make_unique<TimeTask>(&time), 0.05 /* 50ms */);
+  EXPECT_TRUE(WaitFor([&time]() { return time != 0; }));
+  EXPECT_GE(time - start, 50 * 1000 * 1000u);
+}
+
+}  // namespace aworker
@@ -1,7 +1,9 @@
 #include "zero_copy_file_stream.h"
 #include <gtest/gtest.h>
 #include <libgen.h>
+#include <stdio.h>
 #include <unistd.h>
+#include <algorithm>
 #include <iostream>
 #include "common.h"
 #include "proto/test.pb.h"
@@ -72,6 +74,54 @@ TEST(ZeroCopyFileStream, Write) {
   EXPECT_TRUE(ended);
 }
 
+TEST(ZeroCopyFileStream, WriteMultipleBuffersWithSync) {
+  uv_loop_t loop;
+  uv_loop_init(&loop);
+  auto path = tmpdir() + "/UvZeroCopyOutputFileStreamWriteMultiple.out";
+  unlink(path.c_str());
+
+  std::string expected;
+  for (int idx = 0; expected.size() < 1024 * 1024 + 17; idx++) {
+    expected += std::to_string(idx) + ",";
+  }
+
+  bool ended = false;
+  {
+    UvZeroCopyOutputFileStream::Options options;
+    options.sync_bytes = 256 * 1024;
+    auto stream = UvZeroCopyOutputFileStream::Create(
+        &loop,
+        path,
+        options,
+        [&expected, &ended](UvZeroCopyOutputFileStream* stream) {
+          EXPECT_EQ(stream->ByteCount(),
+                    static_cast<int64_t>(expected.size()));
+          ended = true;
+        });
+    ASSERT_NE(stream, nullptr);
+
+    size_t offset = 0;
+    while (offset < expected.size()) {
+      char* buf;
+      int size;
+      EXPECT_TRUE(stream->Next(reinterpret_cast<void**>(&buf), &size));
+      size_t count = std::min(static_cast<size_t>(size) / 3,
+                              expected.size() - offset);
+      memcpy(buf, expected.data() + offset, count);
+      stream->BackUp(size - count);
+      offset += count;
+    }
+  }
+
+  uv_run(&loop, UV_RUN_DEFAULT);
+  assert_uv_loop_close(&loop);
+  EXPECT_TRUE(ended);
+
+  std::string actual;
+  EXPECT_EQ(ReadFileSync(&actual, path.c_str()), 0);
+  EXPECT_EQ(actual, expected);
+}
+
 TEST(ZeroCopyFileStream, ProtoBufferReadWrite) {
   uv_loop_t loop;
   uv_loop_init(&loop);
@@ -118,4 +168,211 @@ TEST(ZeroCopyFileStream, ProtoBufferReadWrite) {
   EXPECT_TRUE(read);
 }
 
+TEST(ZeroCopyFileStream, StreamingRead) {
+  uv_loop_t loop;
+  uv_loop_init(&loop);
+  auto path = cwd() + "/fixtures/text";
+
+  bool read = false;
+  UvStreamingZeroCopyInputFileStream::Create(
+      &loop,
+      path,
+      2,
+      [&read](std::unique_ptr<UvStreamingZeroCopyInputFileStream> stream) {
+        ASSERT_NE(stream, nullptr);
+        EXPECT_EQ(stream->ByteCount(), 0);
+
+        std::string actual = "";
+        const char* buf;
+        int size;
+        while (stream->Next(reinterpret_cast<const void**>(&buf), &size)) {
+          actual += std::string(buf, size);
+        }
+        EXPECT_EQ(actual, "foobar\n");
+        EXPECT_EQ(stream->ByteCount(), 7);
+        EXPECT_EQ(stream->error(), 0);
+        read = true;
+      });
+
+  uv_run(&loop, UV_RUN_DEFAULT);
+  assert_uv_loop_close(&loop);
+  EXPECT_TRUE(read);
+}
+
+TEST(ZeroCopyFileStream, StreamingReadNotFound) {
+  uv_loop_t loop;
+  uv_loop_init(&loop);
+  auto path = cwd() + "/fixtures/not-exists";
+
+  bool called = false;
+  UvStreamingZeroCopyInputFileStream::Create(
+      &loop,
+      path,
+      2,
+      [&called](std::unique_ptr<UvStreamingZeroCopyInputFileStream> stream) {
+        EXPECT_EQ(stream, nullptr);
+        called = true;
+      });
+
+  uv_run(&loop, UV_RUN_DEFAULT);
+  assert_uv_loop_close(&loop);
+  EXPECT_TRUE(called);
+}
+
+TEST(ZeroCopyFileStream, StreamingReadLargeFile) {
+  uv_loop_t loop;
+  uv_loop_init(&loop);
+  auto path = tmpdir() + "/UvStreamingZeroCopyInputFileStreamLarge.out";
+  unlink(path.c_str());
+
+  // Spans multiple chunks, and is not aligned to the chunk size.
+  std::string expected;
+  for (int idx = 0; expected.size() < 1024 * 1024 + 17; idx++) {
+    expected += std::to_string(idx) + ",";
+  }
+  {
+    FILE* fp = fopen(path.c_str(), "w");
+    ASSERT_NE(fp, nullptr);
+    fwrite(expected.data(), 1, expected.size(), fp);
+    fclose(fp);
+  }
+
+  bool read = false;
+  std::string actual = "";
+  std::unique_ptr<UvStreamingZeroCopyInputFileStream> stream;
+  // Resume on the loop whenever the next chunk is not read yet.
+  std::function<void()> consume = [&]() {
+    const char* buf;
+    int size;
+    while (stream->Next(reinterpret_cast<const void**>(&buf), &size)) {
+      actual += std::string(buf, size);
+    }
+    if (stream->would_block()) {
+      stream->Wait(consume);
+      return;
+    }
+    EXPECT_EQ(stream->error(), 0);
+    EXPECT_EQ(actual.size(), expected.size());
+    EXPECT_EQ(actual, expected);
+    EXPECT_EQ(stream->ByteCount(), static_cast<int64_t>(expected.size()));
+    stream.reset();
+    read = true;
+  };
+  UvStreamingZeroCopyInputFileStream::Create(
+      &loop,
+      path,
+      3,
+      [&](std::unique_ptr<UvStreamingZeroCopyInputFileStream> it) {
+        ASSERT_NE(it, nullptr);
+        stream = std::move(it);
+
+        const char* buf;
+        int size;
+        // Back up half of the first chunk and re-read it.
+        ASSERT_TRUE(stream->Next(reinterpret_cast<const void**>(&buf), &size));
+        stream->BackUp(size / 2);
+        EXPECT_EQ(stream->ByteCount(), size - size / 2);
+        actual += std::string(buf, size - size / 2);
+        EXPECT_TRUE(stream->Skip(0));
+        consume();
+      });
+
+  uv_run(&loop, UV_RUN_DEFAULT);
+  assert_uv_loop_close(&loop);
+  EXPECT_TRUE(read);
+}
+
+TEST(ZeroCopyFileStream, StreamingProtoBufferRead) {
+  uv_loop_t loop;
+  uv_loop_init(&loop);
+  auto path = tmpdir() + "/UvStreamingZeroCopyFileStreamProtobufRead.out";
+  unlink(path.c_str());
+
+  // Fields of varying sizes, both the field headers and the field values
+  // span the chunks.
+  test::TestFilePage expected;
+  expected.set_foo(std::string(200 * 1024, 'f'));
+  expected.set_quz("qux");
+  for (int idx = 0; idx < 20000; idx++) {
+    expected.add_items(std::string(idx % 300, 'a' + idx % 26));
+  }
+
+  bool ended = false;
+  {
+    auto stream = UvZeroCopyOutputFileStream::Create(
+        &loop, path, [&ended](UvZeroCopyOutputFileStream* stream) {
+          ended = true;
+        });
+    ASSERT_NE(stream, nullptr);
+    expected.SerializeToZeroCopyStream(stream.get());
+  }
+
+  uv_run(&loop, UV_RUN_DEFAULT);
+  ASSERT_TRUE(ended);
+
+  bool read = false;
+  test::TestFilePage test_file_page;
+  std::unique_ptr<UvStreamingZeroCopyInputFileStream> stream;
+  UvStreamingZeroCopyInputFileStream::Create(
+      &loop,
+      path,
+      1,
+      [&](std::unique_ptr<UvStreamingZeroCopyInputFileStream> it) {
+        ASSERT_NE(it, nullptr);
+        stream = std::move(it);
+        stream->ParseMessage(&test_file_page, [&](bool success) {
+          EXPECT_TRUE(success);
+          EXPECT_EQ(test_file_page.foo(), expected.foo());
+          EXPECT_EQ(test_file_page.quz(), "qux");
+          EXPECT_EQ(test_file_page.SerializeAsString(),
+                    expected.SerializeAsString());
+          stream.reset();
+          read = true;
+        });
+      });
+
+  uv_run(&loop, UV_RUN_DEFAULT);
+  assert_uv_loop_close(&loop);
+  EXPECT_TRUE(read);
+}
+
+TEST(ZeroCopyFileStream, StreamingProtoBufferReadTruncated) {
+  uv_loop_t loop;
+  uv_loop_init(&loop);
+  auto path = tmpdir() + "/UvStreamingZeroCopyFileStreamProtobufTruncated.out";
+  unlink(path.c_str());
+
+  {
+    test::TestFilePage test_file_page;
+    test_file_page.set_foo(std::string(200 * 1024, 'f'));
+    test_file_page.set_quz("qux");
+    std::string data = test_file_page.SerializeAsString();
+    FILE* fp = fopen(path.c_str(), "w");
+    ASSERT_NE(fp, nullptr);
+    fwrite(data.data(), 1, data.size() / 2, fp);
+    fclose(fp);
+  }
+
+  bool read = false;
+  test::TestFilePage test_file_page;
+  std::unique_ptr<UvStreamingZeroCopyInputFileStream> stream;
+  UvStreamingZeroCopyInputFileStream::Create(
+      &loop,
+      path,
+      2,
+      [&](std::unique_ptr<UvStreamingZeroCopyInputFileStream> it) {
+        ASSERT_NE(it, nullptr);
+        stream = std::move(it);
+        stream->ParseMessage(&test_file_page, [&](bool success) {
+          EXPECT_FALSE(success);
+          stream.reset();
+          read = true;
+        });
+      });
+
+  uv_run(&loop, UV_RUN_DEFAULT);
+  assert_uv_loop_close(&loop);
+  EXPECT_TRUE(read);
+}
+
 }  // namespace aworker
@@ -0,0 +1,84 @@
+#include "zlib/zlib_stream_pool.h"
+#include <gtest/gtest.h>
+
+namespace aworker {
+namespace zlib {
+
+namespace {
+const ZlibStreamKey kGzipKey{
+    ZlibStreamKey::Mode::kDeflate, Z_DEFAULT_COMPRESSION, 15 + 16, 8, 0};
+const ZlibStreamKey kInflateKey{ZlibStreamKey::Mode::kInflate, 0, 15, 0, 0};
+
+std::unique_ptr<z_stream> NewDeflateStream(const ZlibStreamKey& key) {
+  std::unique_ptr<z_stream> stream = std::make_unique<z_stream>();
+  EXPECT_EQ(deflateInit2(stream.get(),
+                         key.level,
+                         Z_DEFLATED,
+                         key.window_bits,
+                         key.mem_level,
+                         key.strategy),
+            Z_OK);
+  return stream;
+}
+}  // namespace
+
+TEST(ZlibStreamPool, AcquireReleasedStream) {
+  ZlibStreamPool pool(2);
+  EXPECT_EQ(pool.Acquire(kGzipKey), nullptr);
+
+  std::unique_ptr<z_stream> stream = NewDeflateStream(kGzipKey);
+  unsigned char input[] = "foobar";
+  unsigned char output[64];
+  stream->next_in = input;
+  stream->avail_in = sizeof(input);
+  stream->next_out = output;
+  stream->avail_out = sizeof(output);
+  EXPECT_EQ(deflate(stream.get(), Z_FINISH), Z_STREAM_END);
+  z_stream* raw = stream.get();
+
+  pool.Release(kGzipKey, std::move(stream));
+  EXPECT_EQ(pool.size(), size_t(1));
+  // Different parameters never share streams.
+  EXPECT_EQ(pool.Acquire(kInflateKey), nullptr);
+
+  std::unique_ptr<z_stream> reused = pool.Acquire(kGzipKey);
+  EXPECT_EQ(reused.get(), raw);
+  EXPECT_EQ(pool.size(), size_t(0));
+  // The stream has been reset.
+  EXPECT_EQ(reused->total_in, uLong(0));
+  EXPECT_EQ(reused->total_out, uLong(0));
+  reused->next_in = input;
+  reused->avail_in = sizeof(input);
+  reused->next_out = output;
+  reused->avail_out = sizeof(output);
+  EXPECT_EQ(deflate(reused.get(), Z_FINISH), Z_STREAM_END);
+  EXPECT_EQ(deflateEnd(reused.get()), Z_OK);
+}
+
+TEST(ZlibStreamPool, Capacity) {
+  ZlibStreamPool pool(1);
+  pool.Release(kGzipKey, NewDeflateStream(kGzipKey));
+  pool.Release(kGzipKey, NewDeflateStream(kGzipKey));
+  EXPECT_EQ(pool.size(), size_t(1));
+
+  ZlibStreamPool disabled(0);
+  disabled.Release(kGzipKey, NewDeflateStream(kGzipKey));
+  EXPECT_EQ(disabled.size(), size_t(0));
+}
+
+TEST(ZlibStreamPool, Trim) {
+  ZlibStreamPool pool(4);
+  pool.Release(kGzipKey, NewDeflateStream(kGzipKey));
+  std::unique_ptr<z_stream> inflate_stream = std::make_unique<z_stream>();
+  EXPECT_EQ(inflateInit2(inflate_stream.get(), kInflateKey.window_bits), Z_OK);
+  pool.Release(kInflateKey, std::move(inflate_stream));
+  EXPECT_EQ(pool.size(), size_t(2));
+
+  pool.Trim();
+  EXPECT_EQ(pool.size(), size_t(0));
+  EXPECT_EQ(pool.Acquire(kGzipKey), nullptr);
+  EXPECT_EQ(pool.Acquire(kInflateKey), nullptr);
+}
+
+}  // namespace zlib
+}  // namespace aworker
@@ -37,7 +37,7 @@ function validateContent(report, fields = []) {
 function _validateContent(report, fields = []) {
   // Verify that all sections are present as own properties of the report.
   const sections = [ 'header', 'javascriptStack', 'nativeStack',
-    'javascriptHeap', 'environmentVariables',
+    'javascriptHeap', 'arrayBufferAllocator', 'environmentVariables',
     'sharedObjects', 'libuv', 'resourceUsage', 'userLimits' ];
 
   checkForUnknownFields(report, sections);
@@ -146,6 +146,15 @@ function _validateContent(report, fields = []) {
     });
   });
 
+  // Verify the format of the arrayBufferAllocator section.
+  const allocator = report.arrayBufferAllocator;
+  const allocatorFields = [ 'allocations', 'pooledAllocations',
+    'allocatedMemory', 'pooledMemory' ];
+  checkForUnknownFields(allocator, allocatorFields);
+  allocatorFields.forEach(field => {
+    assert(Number.isSafeInteger(allocator[field]));
+  });
+
   assert(Array.isArray(report.libuv));
   report.libuv.forEach(handle => {
     assert.strictEqual(typeof handle, 'object');
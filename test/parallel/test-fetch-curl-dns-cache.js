@@ -0,0 +1,68 @@
+// META: flags=--experimental-curl-fetch --expose-internals --curl-dns-prewarm=localhost:30125
+'use strict';
+
+const {
+  dnsLookup,
+  dnsPrewarm,
+  dnsCacheSize,
+  DnsResolveReq,
+  DNS_CACHE_MAX_ENTRIES,
+} = loadBinding('curl');
+const { prewarm, resolveFromCache } = load('fetch/drivers/curl');
+
+function resolve(host, port, ttl) {
+  return new Promise(resolve => {
+    const req = new DnsResolveReq();
+    req._onComplete = resolve;
+    assert_true(req.resolve(host, port, ttl));
+  });
+}
+
+test(() => {
+  const size = dnsCacheSize();
+  assert_equals(dnsLookup('localhost', 30126, 60_000), undefined);
+  assert_equals(dnsCacheSize(), size);
+}, 'lookup should not resolve cold host names');
+
+promise_test(async () => {
+  const [ entry ] = await resolveFromCache('http://localhost:30122/echo');
+  const addresses = dnsLookup('localhost', 30122, 60_000);
+  assert_equals(typeof addresses, 'string');
+  assert_equals(entry, `+localhost:30122:${addresses}`);
+
+  assert_array_equals(await resolveFromCache('http://127.0.0.1:30122/echo'), []);
+  assert_array_equals(await resolveFromCache('http://[::1]:30122/echo'), []);
+}, 'resolved host names should be injected with CURLOPT_RESOLVE');
+
+promise_test(async () => {
+  const res = await fetch('http://localhost:30122/echo');
+  assert_equals(res.status, 200);
+  await res.text();
+}, 'fetch with the cached host name');
+
+promise_test(async () => {
+  const addresses = await resolve('localhost', 30127, 100);
+  assert_equals(typeof addresses, 'string');
+  assert_equals(dnsLookup('localhost', 30127, 100), addresses);
+  await new Promise(resolve => setTimeout(resolve, 200));
+  assert_equals(dnsLookup('localhost', 30127, 100), undefined);
+}, 'entries should expire after the ttl');
+
+promise_test(async () => {
+  assert_equals(await resolve('aworker-dns-cache-test.invalid', 80, 100), undefined);
+}, 'resolve unknown host names');
+
+test(() => {
+  prewarm();
+  assert_equals(typeof dnsLookup('localhost', 30125, 60_000), 'string');
+}, 'host names should be resolved by prewarm');
+
+test(() => {
+  for (let idx = 0; idx <= DNS_CACHE_MAX_ENTRIES; idx++) {
+    assert_true(dnsPrewarm('localhost', 40000 + idx, 60_000));
+  }
+  assert_equals(dnsCacheSize(), DNS_CACHE_MAX_ENTRIES);
+  // The least recently used entry is evicted.
+  assert_equals(dnsLookup('localhost', 40000, 60_000), undefined);
+  assert_equals(typeof dnsLookup('localhost', 40000 + DNS_CACHE_MAX_ENTRIES, 60_000), 'string');
+}, 'cache size should be bounded');
@@ -0,0 +1,14 @@
+// META: flags=--expose-internals
+'use strict';
+
+const { CurlMulti, MultiOptions, CURLPIPE_MULTIPLEX } = loadBinding('curl');
+
+test(() => {
+  const multi = new CurlMulti();
+  multi.setOpt(MultiOptions.CURLMOPT_PIPELINING, CURLPIPE_MULTIPLEX);
+  multi.setOpt(MultiOptions.CURLMOPT_MAX_HOST_CONNECTIONS, 6);
+  assert_throws_js(Error, () => {
+    multi.setOpt(0x7fffffff, 1);
+  });
+  multi.close();
+}, 'CurlMulti.setOpt');
@@ -0,0 +1,30 @@
+// META: flags=--expose-internals
+'use strict';
+
+const { setImmediate, clearImmediate } = load('timer');
+
+promise_test(async () => {
+  const order = [];
+  await new Promise(resolve => {
+    setImmediate(() => {
+      order.push(1);
+      setImmediate(() => {
+        order.push('nested');
+        resolve();
+      });
+    });
+    const cleared = setImmediate(() => order.push('cleared'));
+    setImmediate(() => order.push(2));
+    clearImmediate(cleared);
+  });
+  assert_array_equals(order, [ 1, 2, 'nested' ]);
+}, 'immediates queued while draining should be run in the next iteration');
+
+promise_test(async () => {
+  const immediate = setImmediate(() => {});
+  assert_true(immediate.hasRef());
+  assert_false(immediate.unref().hasRef());
+  assert_true(immediate.ref().hasRef());
+  await new Promise(resolve => setImmediate(resolve));
+  assert_false(immediate.hasRef());
+}, 'immediates can be ref\'d and unref\'d');
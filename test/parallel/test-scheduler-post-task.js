@@ -0,0 +1,57 @@
+'use strict';
+
+promise_test(async () => {
+  const order = [];
+  const promises = [
+    scheduler.postTask(() => order.push('background'), { priority: 'background' }),
+    scheduler.postTask(() => order.push('user-visible')),
+    scheduler.postTask(() => order.push('user-blocking'), { priority: 'user-blocking' }),
+  ];
+  await Promise.all(promises);
+  assert_array_equals(order, [ 'user-blocking', 'user-visible', 'background' ]);
+}, 'tasks of higher priorities should be run first');
+
+promise_test(async t => {
+  const ret = await scheduler.postTask(() => 42);
+  assert_equals(ret, 42);
+
+  const error = new Error('foo');
+  await promise_rejects_exactly(t, error, scheduler.postTask(() => {
+    throw error;
+  }));
+}, 'postTask should be settled with the result of the callback');
+
+promise_test(async t => {
+  await promise_rejects_js(t, TypeError, scheduler.postTask(() => {}, { priority: 'foo' }));
+  await promise_rejects_js(t, TypeError, scheduler.postTask('foo'));
+  assert_throws_js(TypeError, () => new Scheduler());
+}, 'invalid arguments');
+
+promise_test(async t => {
+  const controller = new AbortController();
+  controller.abort();
+  let called = false;
+  await promise_rejects_dom(t, 'AbortError', scheduler.postTask(() => {
+    called = true;
+  }, { signal: controller.signal }));
+  assert_false(called);
+}, 'postTask with an aborted signal');
+
+promise_test(async t => {
+  const controller = new AbortController();
+  let called = false;
+  const promise = scheduler.postTask(() => {
+    called = true;
+  }, { signal: controller.signal });
+  controller.abort();
+  await promise_rejects_dom(t, 'AbortError', promise);
+  // Wait for the aborted task to be dequeued.
+  await scheduler.postTask(() => {}, { priority: 'background' });
+  assert_false(called);
+}, 'postTask aborted before run');
+
+promise_test(async () => {
+  const start = Date.now();
+  await scheduler.postTask(() => {}, { delay: 50 });
+  assert_greater_than_equal(Date.now() - start, 40);
+}, 'postTask with delay');
@@ -0,0 +1,22 @@
+// META: flags=--timer-slack-ms=100
+'use strict';
+
+promise_test(async () => {
+  // Align to the start of a slack bucket.
+  await new Promise(resolve => setTimeout(resolve, 1));
+
+  const fired = [];
+  const start = performance.now();
+  await new Promise(resolve => {
+    setTimeout(() => fired.push(performance.now() - start), 10);
+    setTimeout(() => {
+      fired.push(performance.now() - start);
+      resolve();
+    }, 30);
+  });
+  // Timers are never fired before their expiry.
+  assert_greater_than_equal(fired[0], 9);
+  assert_greater_than_equal(fired[1], 29);
+  // Both timers expire in the same slack bucket, and are fired in one wakeup.
+  assert_less_than(fired[1] - fired[0], 5);
+}, 'timers should be coalesced with slack');
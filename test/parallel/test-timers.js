@@ -0,0 +1,42 @@
+'use strict';
+
+promise_test(async () => {
+  const order = [];
+  await new Promise(resolve => {
+    setTimeout(() => order.push(30), 30);
+    setTimeout(() => order.push(10), 10);
+    const cleared = setTimeout(() => order.push('cleared'), 10);
+    setTimeout(() => order.push('10-2'), 10);
+    clearTimeout(cleared);
+    setTimeout(() => {
+      order.push(20);
+      setTimeout(() => order.push('20+5'), 5);
+    }, 20);
+    setTimeout(resolve, 50);
+  });
+  assert_array_equals(order, [ 10, '10-2', 20, '20+5', 30 ]);
+}, 'timers should be fired in the order of their expiry');
+
+promise_test(async () => {
+  let count = 0;
+  await new Promise(resolve => {
+    const interval = setInterval(() => {
+      count++;
+      if (count === 3) {
+        clearInterval(interval);
+        setTimeout(resolve, 30);
+      }
+    }, 5);
+  });
+  assert_equals(count, 3);
+}, 'interval should be rescheduled until cleared');
+
+promise_test(async () => {
+  const storage = new aworker.AsyncLocalStorage();
+  const stores = await Promise.all([ 1, 2, 3 ].map(store => {
+    return storage.run(store, () => new Promise(resolve => {
+      setTimeout(() => resolve(storage.getStore()), 5);
+    }));
+  }));
+  assert_array_equals(stores, [ 1, 2, 3 ]);
+}, 'timers of the same duration should keep their own async context');
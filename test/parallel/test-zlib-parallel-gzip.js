@@ -0,0 +1,106 @@
+// META: flags=--expose-internals --zlib-parallel-gzip-threads=4
+'use strict';
+
+const { zlib } = aworker;
+
+const { Unzip, Zip, UNCOMPRESS_TYPE, COMPRESS_TYPE } = zlib;
+
+async function readAll(readable) {
+  let ret = new Uint8Array(0);
+  while (true) {
+    const { done, value } = await readable.read();
+    if (done) break;
+
+    const after = new Uint8Array(ret.byteLength + value.byteLength);
+    after.set(ret, 0);
+    after.set(new Uint8Array(value), ret.byteLength);
+    ret = after;
+  }
+  return ret;
+}
+
+function isParallel(zlibStream) {
+  const core = Object.getOwnPropertySymbols(zlibStream)
+    .find(it => it.description === 'ZlibWrapper::core');
+  return zlibStream[core].isParallel();
+}
+
+async function roundTrip(input, chunks) {
+  const zip = new Zip(COMPRESS_TYPE.GZIP);
+  const zipWritable = zip.writable.getWriter();
+  const zipReadable = zip.readable.getReader();
+  const step = Math.ceil(input.byteLength / chunks);
+  for (let i = 0; i < input.byteLength; i += step) {
+    zipWritable.write(input.slice(i, i + step));
+  }
+  zipWritable.close();
+  const compressed = await readAll(zipReadable);
+
+  const unzip = new Unzip(UNCOMPRESS_TYPE.GUNZIP);
+  const unzipWritable = unzip.writable.getWriter();
+  const unzipReadable = unzip.readable.getReader();
+  unzipWritable.write(compressed.buffer);
+  unzipWritable.close();
+  const ret = await readAll(unzipReadable);
+  assert_equals(ret.byteLength, input.byteLength);
+  for (let i = 0; i < ret.byteLength; i++) {
+    if (ret[i] !== input[i]) {
+      assert_unreached(`mismatched byte at ${i}`);
+    }
+  }
+  return { compressed, parallel: isParallel(zip) };
+}
+
+function createInput(byteLength) {
+  const input = new Uint8Array(byteLength);
+  let seed = 1;
+  for (let i = 0; i < byteLength; i++) {
+    seed = (seed * 1103515245 + 12345) & 0x7fffffff;
+    input[i] = 0x61 + (seed >> 16) % 16;
+  }
+  return input;
+}
+
+for (const chunks of [ 1, 3 ]) {
+  promise_test(async () => {
+    const input = createInput(3 * 1024 * 1024 + 123);
+    const { compressed, parallel } = await roundTrip(input, chunks);
+    assert_less_than(compressed.byteLength, input.byteLength);
+    assert_true(parallel);
+  }, `parallel gzip with ${chunks} chunks`);
+}
+
+promise_test(async () => {
+  // The first chunk is smaller than the threshold, the stream stays serial.
+  const input = createInput(3 * 1024 * 1024);
+  const { parallel } = await roundTrip(input, 4);
+  assert_false(parallel);
+}, 'serial gzip with small first chunk');
+
+test(() => {
+  const { ZipWrapper, COMPRESS_TYPE: TYPES, FLUSH_MODE } = loadBinding('zlib');
+  const input = createInput(3 * 1024 * 1024);
+  const core = new ZipWrapper(TYPES.GZIP, true, 15, { level: -1, memLevel: 8, strategy: 0 });
+  core.push(input.buffer, 0, input.byteLength, FLUSH_MODE.Z_FINISH);
+  assert_false(core.isParallel());
+}, 'synchronous gzip never goes parallel');
+
+promise_test(async () => {
+  const { ZipWrapper, COMPRESS_TYPE: TYPES, FLUSH_MODE } = loadBinding('zlib');
+  const core = new ZipWrapper(TYPES.GZIP, false, 15, { level: -1, memLevel: 8, strategy: 0 });
+  const push = byteLength => {
+    const input = createInput(byteLength);
+    return new Promise(resolve => {
+      core.push(input.buffer, 0, input.byteLength, FLUSH_MODE.Z_FINISH, (err, result) => resolve({ err, result }));
+    });
+  };
+
+  const finished = push(1024);
+  // Queued before the stream finished.
+  const queued = push(2 * 1024 * 1024);
+  assert_equals((await finished).err, undefined);
+  assert_true((await queued).err != null);
+  // Pushed after the stream finished.
+  assert_true((await push(2 * 1024 * 1024)).err != null);
+  assert_false(core.isParallel());
+}, 'large chunks pushed after gzip finished are rejected');
@@ -0,0 +1,57 @@
+// META: flags=--expose-internals --zlib-threadpool
+'use strict';
+
+const { zlib } = aworker;
+const path = load('path');
+const file = load('file');
+const dirname = path.dirname(location.pathname);
+
+const decoder = new TextDecoder('utf8');
+
+const { FLUSH_MODE, Unzip, Zip, UNCOMPRESS_TYPE, COMPRESS_TYPE } = zlib;
+
+function getUncompressed() {
+  return file.readFile(path.join(dirname, '../fixtures/zlib/1_uncompressed.txt'), 'utf8');
+}
+
+async function readAll(readable) {
+  let ret = new Uint8Array(0);
+  while (true) {
+    const { done, value } = await readable.read();
+    if (done) break;
+
+    const after = new Uint8Array(ret.byteLength + value.byteLength);
+    after.set(ret, 0);
+    after.set(new Uint8Array(value), ret.byteLength);
+    ret = after;
+  }
+  return ret;
+}
+
+for (const [ type, uncompressType ] of [
+  [ COMPRESS_TYPE.DEFLATE, UNCOMPRESS_TYPE.INFLATE ],
+  [ COMPRESS_TYPE.GZIP, UNCOMPRESS_TYPE.GUNZIP ],
+]) {
+  promise_test(async () => {
+    const uncompressed = getUncompressed();
+    const zip = new Zip(type, { flush: FLUSH_MODE.Z_NO_FLUSH });
+    const zipWritable = zip.writable.getWriter();
+    const zipReadable = zip.readable.getReader();
+    // Chunks of one stream must be processed in order even if the tasks are
+    // run on the thread pool.
+    const step = 97;
+    for (let i = 0; i < uncompressed.length; i += step) {
+      zipWritable.write(uncompressed.slice(i, i + step));
+    }
+    zipWritable.close();
+    const compressed = await readAll(zipReadable);
+
+    const unzip = new Unzip(uncompressType);
+    const unzipWritable = unzip.writable.getWriter();
+    const unzipReadable = unzip.readable.getReader();
+    unzipWritable.write(compressed.buffer);
+    unzipWritable.close();
+    const ret = await readAll(unzipReadable);
+    assert_equals(decoder.decode(ret), uncompressed);
+  }, `round trip of type ${type} on thread pool`);
+}
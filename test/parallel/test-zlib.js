@@ -56,6 +56,18 @@ for (const type of [ COMPRESS_TYPE.DEFLATE, COMPRESS_TYPE.GZIP ]) {
       assert_equals(ret[i], std[i]);
     }
   }, `should compress ${typeName}`);
+
+  test(() => {
+    const ret = new Uint8Array(zlib.compressSync(type, uncompressed));
+    const std = new Uint8Array(compressed);
+    assert_equals(ret.byteLength, std.byteLength);
+    for (let i = 0; i < ret.byteLength; i++) {
+      if (type === COMPRESS_TYPE.GZIP && i === 9) {
+        if (ret[i] === 0x13) continue;
+      }
+      assert_equals(ret[i], std[i]);
+    }
+  }, `should compress ${typeName} in sync`);
 }
 
 for (const type of [ UNCOMPRESS_TYPE.UNZIP, UNCOMPRESS_TYPE.GUNZIP, UNCOMPRESS_TYPE.INFLATE ]) {
@@ -121,6 +133,24 @@ for (const type of [ UNCOMPRESS_TYPE.UNZIP, UNCOMPRESS_TYPE.GUNZIP, UNCOMPRESS_T
     assert_equals(decoder.decode(ret), uncompressed);
   }, `${typeName} with chunks`);
 
+  promise_test(async () => {
+    const unzip = new Unzip(type, { flush: FLUSH_MODE.Z_FINISH });
+    const writable = unzip.writable.getWriter();
+    const readable = unzip.readable.getReader();
+    writable.write(compressed);
+    writable.close();
+    let ret = await readable.read();
+    assert_equals(ret.done, false);
+    assert_equals(decoder.decode(ret.value), uncompressed);
+    ret = await readable.read();
+    assert_equals(ret.done, true);
+  }, `${typeName} with Z_FINISH`);
+
+  test(() => {
+    assert_equals(decoder.decode(zlib.decompressSync(type, compressed)), uncompressed);
+    assert_equals(decoder.decode(zlib.decompressSync(type, new Uint8Array(compressed))), uncompressed);
+  }, `${typeName} in sync`);
+
   promise_test(async t => {
     const unzip = new Unzip(type, { flush: FLUSH_MODE.Z_NO_FLUSH });
     const writable = unzip.writable.getWriter();
@@ -212,3 +242,32 @@ promise_test(async t => {
     }
   })());
 }, 'already finished');
+
+test(() => {
+  // Highly compressible input inflates beyond the initial output size.
+  const uncompressed = 'aworker'.repeat(256 * 1024);
+  for (const type of [ COMPRESS_TYPE.DEFLATE, COMPRESS_TYPE.GZIP ]) {
+    const compressed = zlib.compressSync(type, uncompressed, { level: 9 });
+    assert_equals(decoder.decode(zlib.decompressSync(UNCOMPRESS_TYPE.UNZIP, compressed)), uncompressed);
+  }
+  assert_equals(zlib.decompressSync(UNCOMPRESS_TYPE.UNZIP, new ArrayBuffer(0)).byteLength, 0);
+}, 'round trip in sync');
+
+test(() => {
+  assert_throws_exactly('inflate() failed with status -3, incorrect header check.', () => {
+    try {
+      zlib.decompressSync(UNCOMPRESS_TYPE.GUNZIP, getDeflateCompressed());
+    } catch (e) {
+      throw e.message;
+    }
+  });
+
+  const compressed = getGzipCompressed();
+  assert_throws_exactly('unexpected end of file', () => {
+    try {
+      zlib.decompressSync(UNCOMPRESS_TYPE.GUNZIP, compressed.slice(0, compressed.byteLength - 8));
+    } catch (e) {
+      throw e.message;
+    }
+  });
+}, 'invalid data in sync');
@@ -149,6 +149,10 @@ function ConcreteToValue(name, type, root) {
       result += `v8::Local<v8::Value> _${name} = v8::Number::New(isolate, nested_${name});`;
       break;
     }
+    case 'uint64': {
+      result += `v8::Local<v8::Value> _${name} = v8::Number::New(isolate, static_cast<double>(nested_${name}));`;
+      break;
+    }
     case 'bytes': {
       result += `
 v8::Local<v8::Value> _${name} = aworker_proto::BytesHelper::ToValue(nested_${name}, context);
@@ -205,6 +209,10 @@ function ConcreteFromValue(name, type, root, repeating = false) {
       result += `target->set_${name}(_${name}->Int32Value(context).ToChecked());`;
       break;
     }
+    case 'uint64': {
+      result += `target->set_${name}(static_cast<uint64_t>(_${name}->IntegerValue(context).ToChecked()));`;
+      break;
+    }
     // reference type
     default: {
       const canonicalName = getTypeCanonicalName(type, root);
@@ -105,6 +105,22 @@ declare namespace aworker {
       constructor(type: ZipType, options?: ZipOptions);
     }
 
+    /**
+     * Compress the whole data in one call on the calling thread.
+     * @param type The zip type.
+     * @param data The data to be compressed.
+     * @param options The zip options, `flush` is ignored.
+     */
+    export function compressSync(type: ZipType, data: BufferLike, options?: ZipOptions): ArrayBuffer;
+
+    /**
+     * Uncompress the whole data on the calling thread.
+     * @param type The unzip type.
+     * @param data The data to be uncompressed.
+     * @param options The unzip options, `flush` is ignored.
+     */
+    export function decompressSync(type: UnzipType, data: BufferLike, options?: UnzipOptions): ArrayBuffer;
+
     export const COMPRESS_TYPE = ZipType;
     export const UNCOMPRESS_TYPE = UnzipType;
     export const FLUSH_MODE = FlushMode;